@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# This script times the analysis of synthetic campaigns of growing length.
+# Compile main.cc into ./test first, then run with:
+# sh benchmark.sh
+
+# the output we append the timing of each analysis to
+outputfile="bench_output.txt"
+
+# the number of runs in each campaign
+runs="4"
+
+# the entries per run, one per second
+for entries in 18000 54000 162000
+do
+    directory="bench_"$entries
+    echo "Generating "$runs" runs of "$entries" entries into "$directory
+
+    # write the tuples and their runlist
+    ./test --generate $directory --runs $runs --entries $entries
+
+    # analyse them, this appends one line to the output
+    ./test $directory/runlist.txt --benchmark $outputfile --output $directory/output.root
+
+    echo " "
+done
+
+echo "Done! The timing is in "$outputfile
@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# This script checks the analysis on a synthetic run: the loop backend and the RDataFrame backend have to give
+# bit for bit the same results, and the closed-form fits have to agree with TGraphErrors fits.
+# Compile main.cc into ./test first, then run with:
+# sh check.sh
+
+# the directory of the synthetic run
+directory="check_run"
+
+# two runs are written, the first shard only analyses the first one
+./test --generate $directory --runs 2 --entries 54000 || exit 1
+
+# the results of the loop backend and of the RDataFrame backend on four threads
+# --fitcheck stops if a slope or offset differs from its TGraphErrors fit by more than 0.1 of its error
+./test $directory/runlist.txt --shard 0/2 --backend 0 --output $directory/loops.root --fitcheck || exit 1
+./test $directory/runlist.txt --shard 0/2 --backend 1 --threads 4 --output $directory/rdataframe.root || exit 1
+
+# the calibrations, stable points, fits and time graphs of the run
+if cmp -s $directory/loops.results $directory/rdataframe.results
+then
+    echo "The backends agree!"
+else
+    echo "Error: the backends give different results!"
+    exit 1
+fi
@@ -1,7 +1,7 @@
 #!/bin/bash
 
 # This script generates a runlist for use in the analysis.
-# Run with:
+# Compile main.cc into ./test first, then run with:
 # sh generate_runlist.sh
 
 # the directory we are in
@@ -10,8 +10,6 @@ echo "running in "$location
 
 # create the output we write to
 outputfile="outputlist.txt"
-touch $outputfile
-echo "# Runlist:" > $outputfile
 
 # the sensorsorting
 sensorsort="0432156789"
@@ -22,43 +20,8 @@ broken="4"
 # sample thickness
 thickness="50"
 
-# dummy filename
-oldfile="fail"
-
-# read in the grep result, up to the first : to result, remainder into temp
-while IFS=: read -r result temp
-do
-    # strip away the .xml
-    file="$(echo $result | awk -F'.xml' '{print $1}')"
-    appendix='.root'
-    newfile=$file$appendix
-    echo "File to open:" $newfile
-    # filename is now in newfile
-
-    # remove everyting up to the >
-    descr="$(echo $temp | awk -F'>' '{print $2}')"
-    # remove the </Log
-    descr="$(echo $descr | awk -F'<' '{print $1}')"
-    echo "File description:" $descr
-    # descr now holds the file info
-
-    # did we just write this file?
-
-    if [ $newfile != $oldfile ]; then
-
-	# write the vars to the output
-	echo $newfile,$sensorsort,$broken,$thickness,$descr >> $outputfile
-	echo "New file!"
-	
-    fi
-
-    oldfile=$newfile
-
-    echo " "
-
-done <<< "`grep -rnw '../' -e "Log time" | grep -v "\thomas/*" | grep -v "\nils/*"`"
-# grep one directory up, -e "" and pipe the output excluding some subdirs...
-
-
+# search one directory up, excluding some subdirs, for the daq logs and their tuples
+# only directories changed since the last run are searched again, see outputlist.txt.cache
+./test $outputfile --discover ../ --exclude thomas --exclude nils --sorting $sensorsort --broken $broken --thickness $thickness
 
 echo "Done!"
@@ -5,10 +5,25 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <iterator>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <functional>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <sys/wait.h>
+#include <dirent.h>
 
 //Root headers
+#include "RVersion.h"
 #include "TROOT.h"
 #include "TH1.h"
 #include "TH1D.h"
@@ -20,16 +35,24 @@
 #include "TLine.h"
 #include "TLegend.h"
 #include "TTree.h"
+#include "TLeaf.h"
+#include "TKey.h"
 #include "TObject.h"
 #include "TGraph.h"
 #include "TGraphErrors.h"
 #include "TFile.h"
-#include "TDatime.h"
 #include "TF1.h"
 #include "TColor.h"
 #include "TH1F.h"
 #include "TPaveText.h"
 #include "TMultiGraph.h"
+#include "TStopwatch.h"
+#include "TSystem.h"
+#include "TRandom3.h"
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,16,0)
+#include "ROOT/RDataFrame.hxx"
+#include "ROOT/RVec.hxx"
+#endif
 
 // the namespace we are working in
 using namespace std;
@@ -46,6 +69,8 @@ g++ -I `root-config --incdir` -o test main.cc `root-config --libs` -Wall -std=c+
 Then run: ./test /path/to/runlist
 Change test in the above two lines to a different executable name if you want.
 
+Analyse several runs in parallel with: ./test /path/to/runlist --threads N
+
 ********************
 
 Run this script in ROOT with:
@@ -79,17 +104,107 @@ int mode = 3;
 // output verbosity from loud = 0  to silent = 5
 int debug = 3;
 
-// the output file we want to save into
-TFile * outputFile = new TFile("output.root", "RECREATE");
+// the output file we want to save into, opened once the options are read
+std::string outputname = "output.root";
+TFile * outputFile = 0;
+
+// the compression of the output and the series files as root writes it: 100 * algorithm + level, -1 = the root default
+int compression = -1;
+
+// analyse only every shards-th run of the runlist, starting with run shard, into its own output and results file
+int shard = 0;
+int shards = 1;
+
+// the results files of the shards to merge into the comparisons, empty = analyse the runs
+std::vector<std::string> mergelist;
+
+// follow the tuple of the last run while the daq is writing it: 0 = off, 1 = on
+int follow = 0;
+
+// replay the recorded tuple of the last run this many times faster than it was taken and follow the copy, 0 = off
+double replayspeed = 0.0;
+
+// write a synthetic campaign into this directory instead of analysing a runlist, empty = off
+std::string generatedir = "";
+
+// find the runs in these directories and write them into the runlist instead of analysing it, empty = off
+std::vector<std::string> discoverlist;
+
+// directories with these names are not searched for runs
+std::vector<std::string> excludelist;
+
+// the sensor sorting, broken sensors and thickness written for each run found
+std::string discoversorting = "0432156789";
+std::string discoverbroken = "4";
+std::string discoverthickness = "50";
+
+// the synthetic campaign: the number of runs, their length in entries (one per second) and the noise of the sensors in K
+int generateruns = 4;
+long int generateentries = 54000;
+double generatenoise = 0.0002;
+
+// append the time of each stage as a line of json to this file, empty = off
+std::string benchmarkfile = "";
+
+// write the counters and stage times of each run as json into this file, empty = off
+std::string summaryfile = "";
+
+// write the stages of each run as a timeline in the chrome trace format into this file, empty = off
+std::string tracefile = "";
 
 // write out every nth event
 int precision = 50;
 
-// the ntuple we read in
-TTree *mytuple;
+// the largest number of points in a time graph, more points are downsampled for the plot only, 0 = all points
+int plotpoints = 2000;
+
+// stream every analysed point of each run into a tree in its own file, in a directory next to the output, 1 = on
+int seriesmode = 0;
+std::string seriesdir = "";
+
+// only write the numbers: no canvases, legends or frames are booked or drawn, the graphs are written as they are, 1 = on
+int headless = 0;
 
-// the entry count of a tuple
-long int tupleentrycount = 0;
+// fit every stable point again with TGraphErrors and stop if the closed-form fits do not agree, 1 = on
+int fitcheck = 0;
+
+// write a table of all stable points into this file, empty = off, by default on in headless mode
+std::string tablename = "";
+
+// make the plots of the runs in this many processes once all results are known, 1 = in this process
+int renderprocesses = 1;
+
+// save every canvas as an image in these formats, e.g. png or png,pdf, into a directory next to the output, empty = off
+std::string exportformats = "";
+std::string exportdir = "";
+
+// the number of measurement runs analysed in parallel, 0 = one per core
+int threads = 1;
+
+// reading of the tuples: 0 = all branches, no read cache, 1 = only the used branches through a TTreeCache
+int iomode = 1;
+
+// the largest read cache for a tuple in bytes
+const long int maxcachesize = 64*1024*1024;
+
+// the directory of the column cache of the tuples, empty = read the tuples with root every time
+std::string cachedir = "";
+
+// the directory of the stored results of each run, empty = analyse all runs every time
+std::string storedir = "";
+
+// the execution of the tuple loops: 0 = hand-written loops, 1 = RDataFrame, one event loop per range of the tuple on each thread
+int backend = 0;
+
+// in mode 3, read and sort each point only once and run calibration and analysis from a buffer: 0 = off, 1 = on
+int fused = 1;
+
+// the calibration of the buffered points: 0 = point by point, 1 = block kernel over all points of a run
+int kernel = 1;
+
+// the time window of the stability detector in s, read at the full rate of the tuple
+// 0 = compare each sensor with the previous point
+double stablewindow = 0.0;
 
 
 // ********************
@@ -105,11 +220,39 @@ const double deltacali = 0.001;
 // max allowed change in a sensor's temperature to be considered stable for gradients
 const double deltagrad = 0.0075;
 
-// max number of sensor calibrations in a run
-const int maxcalibs = 8;
+// the tuple entries between two searches for a calibration
+const int calibrationgap = 2500;
+
+// the stable tuple entries between two gradient points
+const int gradientgap = 100;
+
+// a step between two time stamps longer than this is a gap in the daq, in s
+const unsigned int daqgap = 60;
+
+// the time stamps are checked in blocks of this many entries
+const int clockblock = 4096;
+
+// the series trees are written in baskets of this many points, so they take the same memory for any run length
+const int serieschunk = 10000;
 
-// max number of stable temperature points for gradients
-const int maxstable = 50;
+// with a series, the points kept for the time graphs are thinned whenever there are this many times plotpoints of them
+const int seriescompact = 32;
+
+// when following a tuple: the time between looks for new entries and the time without new entries after which the run is over, in s
+const double followinterval = 0.2;
+const double followtimeout = 60.0;
+
+// the stages of the analysis that are timed
+const int nstages = 8;
+const int stagebooking = 0;
+const int stageopen = 1;
+const int stageread = 2;
+const int stagecalibration = 3;
+const int stageanalysis = 4;
+const int stagefits = 5;
+const int stageplotting = 6;
+const int stagecomparison = 7;
+const char* const stagename[nstages] = {"booking", "open", "read", "calibration", "analysis", "fits", "plotting", "comparison"};
 
 // resistance of the heating element in ohms
 const double resistor = 20.0;
@@ -124,8 +267,17 @@ const double greasetemp = 0.00;
 // assuming an error on all temperature measurements...
 const double errorpercentage = 0.01;
 
-// the total number of different measurement runs
-const int maxmeas = 100;
+// the position of the sensors 1 to 8 in the blocks in mm, from top (heat source) to bottom (bath)
+const double sensorposition[8] = {72,64,56,48,32,24,16,8};
+
+// the error on the sensor positions in mm
+const double positionerror = 1.0;
+
+// the passes of the closed-form fits at most, each puts the slope of the one before into the weights
+const int fititerations = 50;
+
+// with --fitcheck the slopes and offsets of the closed-form fits have to agree with a TGraphErrors fit within this fraction of their errors
+const double fittolerance = 0.1;
 
 
 // ********************
@@ -141,6 +293,12 @@ std::vector<std::string> sensorsort;
 // list of broken sensors to skip
 std::vector<std::string> brokenlist;
 
+// the sorting compiled once per run: the sensor read at each position, from top to bottom
+std::vector<std::vector<int> > sortorder;
+
+// the broken sensors compiled once per run: bit i is set if the sensor at position i is broken
+std::vector<unsigned int> brokenmask;
+
 // the materials used in each measurement, sorted by measurement
 std::vector<std::string> material;
 
@@ -159,121 +317,452 @@ std::vector<int> thicknesslist;
 // a count on the different thicknesses
 int thicknesscount;
 
+// the index of the material and of the thickness of each measurement in materiallist and thicknesslist
+std::vector<int> materialid;
+std::vector<int> thicknessid;
+
 // any other comments logged for a run
 std::vector<std::string> comments;
 
 
 // ********************
-// the variables to read into:
+// straight line fits, one entry per stable point
+// ********************
+
+struct linefits
+{
+
+	// offset and slope of the line
+	std::vector<double> offset, slope;
+
+	// their covariance
+	std::vector<double> covoffset, covmixed, covslope;
+
+	// the quality of the fit
+	std::vector<double> chi2;
+	std::vector<int> ndf;
+
+};
+
+
+// ********************
+// the results of a single measurement run
+// ********************
+
+// one vector per quantity, they grow with the calibrations and stable points found, there is no limit on either
+struct runresult
+{
+
+	// the calibration counter
+	int calibs;
+
+	// the working temperature at a calibration point
+	std::vector<float> work_Temperature;
+
+	// the time of the calibration
+	std::vector<double> calitime;
+
+	// the temperature of a sensor at a calibration point
+	std::vector<float> calitemp[sensors];
+
+	// the average temperature of a sensor over all calibrations, and its spread
+	float avg_calitemp[sensors];
+	float avg_calierror[sensors];
+
+	// no calibration was found, the analysis was skipped
+	bool aborted;
+
+	// the number of stable measurement points
+	int stablepoints;
+
+	// points of stable temperature used for futher analysis
+	std::vector<float> stabletemp[sensors];
+
+	// the working temperature at these points
+	std::vector<float> stablework;
+
+	// the current at these points
+	std::vector<float> stablecurrent;
+
+	// the time of these points
+	std::vector<float> stabletime;
+
+	// the temperature difference between bottom and top blocks
+	std::vector<float> tempdiff;
+
+	// the temperature at which the difference is measured
+	std::vector<float> tempdifftemp;
+
+	// the fits to the lower and the upper block at these points
+	linefits fitlow, fithigh;
+
+	// the times at which the plateaus in the analysis start and end
+	std::vector<float> plateaustart, plateauend;
+
+	// the downsampled points of the time graphs of each sensor
+	std::vector<double> graphtime[sensors], deltagraphtime[sensors];
+	std::vector<float> graphtemperature[sensors], graphdeltaDT[sensors];
+
+	runresult() : calibs(0), aborted(false), stablepoints(0)
+	{
+		for (int i=0;i<sensors;i++)
+		{
+			avg_calitemp[i] = 0.0;
+			avg_calierror[i] = 0.0;
+		}
+	}
+
+};
+
+// the results of all runs, in runlist order
+std::vector<runresult> results;
+
+
+// ********************
+// the counters and stage times of a single measurement run
+// ********************
+
+// a stage on the timeline: when it started and ended, in s, and the thread it ran in, 0 = main thread
+struct tracespan
+{
+	int stage;
+	int thread;
+	double start, end;
+};
+
+struct runprofile
+{
+
+	// the results were taken from the store
+	bool stored;
+
+	// the thread the run was analysed in, 0 = main thread
+	int worker;
+
+	// the entries in the tuple and the entries analysed after the decimation
+	long int entries, usedentries;
+
+	// the bytes read from the file and the bytes decompressed from it
+	long long bytesread, bytesunzipped;
+
+	// the stable points found and the lines fitted to them
+	int stablepoints, fits;
+
+	// the gaps in the daq and the repeated time stamps
+	long int gaps, duplicates;
+
+	// the roots booked for this run and the bytes they take in the output
+	long int objects;
+	long long outputbytes;
+
+	// the time spent in each stage and when each stage ran
+	double stagetime[nstages];
+	std::vector<tracespan> spans;
+
+	runprofile() : stored(false), worker(0), entries(0), usedentries(0), bytesread(0), bytesunzipped(0), stablepoints(0), fits(0), gaps(0), duplicates(0), objects(0), outputbytes(0)
+	{
+		for (int i=0;i<nstages;i++)
+		{
+			stagetime[i] = 0.0;
+		}
+	}
+
+};
+
+// the profile of each run, in runlist order, and of the stages that work on all runs
+std::vector<runprofile> profiles;
+runprofile campaignprofile;
+
+
+// ********************
+// a function to tell if a run is analysed by this process
+// ********************
+
+bool runselected(int ii)
+{
+	return mergelist.empty() && ii % shards == shard && (follow == 0 || ii == (int)filelist.size()-1);
+}
+
+
+// ********************
+// a function to tell if the plots of a run are made by this process, a merge plots all runs
 // ********************
 
-// the measurement time
-unsigned int uTime;
+bool runplotted(int ii)
+{
+	return runselected(ii) || !mergelist.empty();
+}
 
-// the sensor temperature
-float temperature[sensors] = {0.0};
 
-// the current applied to the resistor
-float current1 = 0.0;
+// ********************
+// a function to return the wall time in s since it was first called
+// ********************
 
-// the working temperature that is set
-float workingTemperature = 0.0;
+double walltime()
+{
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
 
 // ********************
-// operational variables
+// a function to get the number of threads for some work: --threads N, 0 = one per core, never more than the work
 // ********************
 
+int threadcount(int work)
+{
+	int nthreads = threads;
+	if (nthreads <= 0)
+	{
+		nthreads = std::thread::hardware_concurrency();
+	}
+	return std::max(1, std::min(nthreads, work));
+}
+
+
 // ********************
-// booleans
+// this function does fn(k, worker) for k = 0 ... count-1 on threadcount(count) threads, each takes the next k from a queue
+// the calling thread is worker 0 and helps, the order in which the work is done is not fixed
 // ********************
 
-// inside the calibration
-bool insidecool, insideend, lookForCal = false;
+void parallelfor(int count, const std::function<void(int, int)>& fn)
+{
+	int nthreads = threadcount(count);
+	std::atomic<int> next(0);
+	std::vector<std::thread> workers;
+	for (int t=1;t<nthreads;t++)
+	{
+		workers.push_back(std::thread([&, t]()
+		{
+			for (int k = next++; k < count; k = next++)
+			{
+				fn(k, t);
+			}
+		}));
+	}
+	for (int k = next++; k < count; k = next++)
+	{
+		fn(k, 0);
+	}
+	for (size_t t=0;t<workers.size();t++)
+	{
+		workers.at(t).join();
+	}
+}
 
 
 // ********************
-// floats
+// a function to end a stage that started at starttime, in the thread the run is analysed in
 // ********************
 
-// the working temperature at a calibration point
-float work_Temperature[maxmeas][maxcalibs] = {0.0};
+void stagedone(runprofile& profile, int stage, double starttime)
+{
+	tracespan span;
+	span.stage = stage;
+	span.thread = profile.worker;
+	span.start = starttime;
+	span.end = walltime();
+	profile.stagetime[stage] += span.end - span.start;
+	profile.spans.push_back(span);
+}
+
 
-// the previous working temperature
-float workingTemperaturebefore  = -100.0;
+// ********************
+// the stability detector: running sums of time and temperature over a time window, for every sensor
+// ********************
 
-// the sensor temperature at the previous measurement point
-float temperaturebefore[sensors] = {0.0};
+// the points of the window are kept in a ring buffer, each new point is added to the sums and the points leaving the window are subtracted
+struct stabilitywindow
+{
 
-// the resulting temperature difference in a sensor
-float deltaT[sensors] = {0.0};
+	// the points in the window, starting at the oldest
+	std::vector<double> time;
+	std::vector<float> temperature[sensors];
+	size_t first, count;
 
-// the temperature difference between different sensors
-float deltaDT[sensors] = {0.0};
+	// the reference point of the sums, to keep them small
+	double time0;
+	float temperature0[sensors];
 
-// the temperature of a sensor at a calibration point
-float calitemp[maxmeas][sensors][maxcalibs] = {0.0};
+	// the running sums over the window
+	double st, stt;
+	double sy[sensors], syy[sensors], sty[sensors];
 
-// the average temperature of a sensor over all calibrations
-float avg_calitemp[maxmeas][sensors] = {0.0};
+	stabilitywindow() : first(0), count(0), time0(0.0), st(0.0), stt(0.0)
+	{
+		for (int i=0;i<sensors;i++)
+		{
+			temperature0[i] = 0.0;
+			sy[i] = 0.0;
+			syy[i] = 0.0;
+			sty[i] = 0.0;
+		}
+	}
 
-// points of stable temperature used for futher analysis
-float stabletemp[maxmeas][sensors][maxstable] = {0.0};
+};
 
-// the working temperature at these points
-float stablework[maxmeas][maxstable] = {0.0};
 
-// the current at these points
-float stablecurrent[maxmeas][maxstable] = {0.0};
+// ********************
+// the clock of a run: the time stamps seen so far, with the gaps and the repeated time stamps found in them
+// ********************
 
-// the time of these points
-float stabletime[maxmeas][maxstable] = {0.0};
+struct runclock
+{
 
-// the temperature difference between bottom and top blocks
-float tempdiff[maxmeas][maxstable] = {0.0};
+	// the number of time stamps checked, the first and the last one
+	long int entries;
+	unsigned int first, last;
 
-// the temperature at which the difference is measured
-float tempdifftemp[maxmeas][maxstable] = {0.0};
+	// the gaps in the daq and the longest step, the time stamps equal to the previous one and those before it
+	long int gaps, duplicates, backwards;
+	unsigned int longeststep;
 
-// the average temperature difference
-float avg_tempdiff = 0.0;
+	runclock() : entries(0), first(0), last(0), gaps(0), duplicates(0), backwards(0), longeststep(0)
+	{
+	}
 
-// the temperature gradient between both aluminium blocks
-float gradient_blocks = 0.0;
+};
 
 
 // ********************
-// integers
+// the state of a single measurement run
 // ********************
 
-// the number of points in a graph
-int usedpoints = 0;
+// everything that changes while looping the tuple of one run lives here, so that runs can be analysed in parallel
+struct runstate
+{
+
+	// the input file
+	TFile* inputfile;
+
+	// the ntuple we read in
+	TTree* mytuple;
+
+	// the entry count of a tuple
+	long int tupleentrycount;
+
+	// the measurement time
+	unsigned int uTime;
+
+	// the sensor temperature
+	float temperature[sensors];
+
+	// the current applied to the resistor
+	float current1;
+
+	// the working temperature that is set
+	float workingTemperature;
+
+	// inside the calibration
+	bool insidecool, lookForCal;
+
+	// the previous working temperature
+	float workingTemperaturebefore;
+
+	// the sensor temperature at the previous measurement point
+	float temperaturebefore[sensors];
 
-// the number of measurement points between two calibrations
-int inbetween = 0;
+	// the resulting temperature difference in a sensor
+	float deltaT[sensors];
 
-// a temp time
-int temptime = 0;
+	// the stability detector and whether we are on a plateau
+	stabilitywindow window;
+	bool plateau;
 
-// the calibration counter
-int calibs[maxmeas] = {0};
+	// the temperature difference between different sensors
+	float deltaDT[sensors];
 
-// the number of stable measurement points
-int stablepoints[maxmeas] = {0};
+	// the number of points in a graph
+	int usedpoints;
 
-// a sign to separate points in a plot
-int pointsep = -1;
+	// the analysed points for the time graphs, downsampled when the run is done
+	std::vector<double> plottime;
+	std::vector<float> plottemperature[sensors], plotdeltaDT[sensors];
+
+	// the number of measurement points between two calibrations
+	int inbetween;
+
+	// the time stamps of the run and the time of the current point in s since the start of the run
+	runclock clock;
+	double time1;
+
+	// the bytes read from the file and the bytes decompressed from it
+	long long bytesread, bytesunzipped;
+
+	// the mapped column cache of the tuple, if used, with the columns of the sorted positions
+	void* cachemap;
+	size_t cachemapsize;
+	const unsigned int* cachetime;
+	const float* cachetemperature[sensors];
+	const float* cachecurrent;
+	const float* cacheworking;
+
+	// the console output of this run, printed in runlist order once the run is written
+	std::ostringstream messages;
+
+	// the file and tree the analysed points are streamed into, with the entry, the stability and the stable point of a point
+	TFile* seriesfile;
+	TTree* seriestree;
+	long long seriesentry;
+	bool seriesstable, seriesplateau;
+	int seriespoint;
+
+	runstate() : inputfile(0), mytuple(0), tupleentrycount(0), uTime(0), current1(0.0), workingTemperature(0.0), insidecool(false), lookForCal(false), workingTemperaturebefore(-100.0), plateau(false), usedpoints(0), inbetween(0), time1(0.0), bytesread(0), bytesunzipped(0), cachemap(0), cachemapsize(0), cachetime(0), cachecurrent(0), cacheworking(0), seriesfile(0), seriestree(0), seriesentry(0), seriesstable(false), seriesplateau(false), seriespoint(-1)
+	{
+		for (int i=0;i<sensors;i++)
+		{
+			cachetemperature[i] = 0;
+			temperature[i] = 0.0;
+			temperaturebefore[i] = 0.0;
+			deltaT[i] = 0.0;
+			deltaDT[i] = 0.0;
+		}
+	}
+
+};
 
 
 // ********************
-// doubles
+// the decimated points of a run, read and sorted once
 // ********************
 
-// for the time
-double time1, time0  = 0.0;
+// one vector per quantity, so the calibration and the analysis can loop the points without touching the tuple again
+struct sampleseries
+{
+
+	// the tuple entry of each point
+	std::vector<long int> entry;
+
+	// the continuous time of each point
+	std::vector<double> time;
 
-// the time of the calibration
-double calitime[maxmeas][maxcalibs] = {0.0};
+	// the sorted sensor temperatures
+	std::vector<float> temperature[sensors];
+
+	// the current applied to the resistor
+	std::vector<float> current1;
+
+	// the working temperature that is set
+	std::vector<float> workingTemperature;
+
+	// the calibration is already applied to the temperatures, with the differences between sensors
+	bool calibrated;
+	std::vector<float> deltaDT[sensors];
+
+	// the change of each sensor over the window of the stability detector
+	bool windowed;
+	std::vector<float> deltaT[sensors];
+
+	// with a series the run is read again in blocks for calibration and analysis: the number of the first point of
+	// the block, the next tuple entry to read and if the buffered points were given out already
+	bool streamed;
+	long int first;
+	long int nextentry;
+	bool done;
+
+	sampleseries() : calibrated(false), windowed(false), streamed(false), first(0), nextentry(0), done(false) {}
+
+};
 
 
 // ********************
@@ -285,20 +774,20 @@ double calitime[maxmeas][maxcalibs] = {0.0};
 // ********************
 
 // graphs for the calibrations, also lines for the position in time
-TGraphErrors* calibrationgraph[maxmeas][maxcalibs];
-TLine* caliposition[maxmeas][maxcalibs];
+std::vector<std::vector<TGraphErrors*> > calibrationgraph;
+std::vector<std::vector<TLine*> > caliposition;
 
 // an average calibration graph
-TGraphErrors* avg_calibrationgraph[maxmeas];
+std::vector<TGraphErrors*> avg_calibrationgraph;
 
 // a canvas for the calibrations
-TCanvas* c_cali[maxmeas];
+std::vector<TCanvas*> c_cali;
 
 // a histogram for the calibrations
-TH2D* h_cali[maxmeas];
+std::vector<TH2D*> h_cali;
 
 // a legend for the calibrations
-TLegend* l_cali[maxmeas];
+std::vector<TLegend*> l_cali;
 
 
 // ********************
@@ -306,17 +795,17 @@ TLegend* l_cali[maxmeas];
 // ********************
 
 // graphs for the sensor temperatures
-TGraphErrors* tempgraph[maxmeas][sensors];
-TGraphErrors* deltatempgraph[maxmeas][sensors];
+std::vector<std::vector<TGraphErrors*> > tempgraph;
+std::vector<std::vector<TGraphErrors*> > deltatempgraph;
 
 // a canvas for the temperatures
-TCanvas* c_temps[maxmeas];
+std::vector<TCanvas*> c_temps;
 
 // a histogram for the temperatures
-TH2D* h_temps[maxmeas];
+std::vector<TH2D*> h_temps;
 
 // a legend for the temperatures
-TLegend* l_temps[maxmeas];
+std::vector<TLegend*> l_temps;
 
 
 // ********************
@@ -324,13 +813,13 @@ TLegend* l_temps[maxmeas];
 // ********************
 
 // a canvas for the delta temperatures
-TCanvas* c_deltatemps[maxmeas];
+std::vector<TCanvas*> c_deltatemps;
 
 // a histogram for the delta temperatures
-TH2D* h_deltatemps[maxmeas];
+std::vector<TH2D*> h_deltatemps;
 
 // a legend for the delta temperatures
-TLegend* l_deltatemps[maxmeas];
+std::vector<TLegend*> l_deltatemps;
 
 
 // ********************
@@ -340,57 +829,42 @@ TLegend* l_deltatemps[maxmeas];
 // graphs for the temperature gradients
 // also fits for this
 // and lines to show the position in time
-TGraphErrors* gradgraph[maxmeas][maxstable];
-TF1* gradfit1[maxmeas][maxstable];
-TF1* gradfit2[maxmeas][maxstable];
-TLine* gradposition[maxmeas][maxstable];
+std::vector<std::vector<TGraphErrors*> > gradgraph;
+std::vector<std::vector<TF1*> > gradfit1;
+std::vector<std::vector<TF1*> > gradfit2;
+std::vector<std::vector<TLine*> > gradposition;
 
 // a canvas for the temperature gradients
-TCanvas* c_gradtemps[maxmeas];
+std::vector<TCanvas*> c_gradtemps;
 
 // a histogram for the temperature gradients
-TH2D* h_gradtemps[maxmeas];
+std::vector<TH2D*> h_gradtemps;
 
 // a legend for the temperature gradients
-TLegend* l_gradtemps[maxmeas];
+std::vector<TLegend*> l_gradtemps;
 
 // a histogram for the temperature differences from the gradients
-TH1D* h_blockdifference[maxmeas];
+std::vector<TH1D*> h_blockdifference;
 
 
 // ********************
 // measurement comparison
 // ********************
 
-TCanvas* c_calicompthick[maxmeas];
-TH2D* h_calicompthick[maxmeas];
-TLegend* l_calicompthick[maxmeas];
-
-TCanvas* c_calicompmaterial[maxmeas];
-TH2D* h_calicompmaterial[maxmeas];
-TLegend* l_calicompmaterial[maxmeas];
+std::vector<TH1D*> h_blockcompmaterial;
+std::vector<TH2D*> h_blockcompmaterial_2D;
 
-
-TCanvas* c_blockcompthick[maxmeas];
-TH1D* h_blockcompthick[maxmeas];
-TLegend* l_blockcompthick[maxmeas];
-
-TCanvas* c_blockcompmaterial[maxmeas];
-TH1D* h_blockcompmaterial[maxmeas];
-TLegend* l_blockcompmaterial[maxmeas];
-TH2D* h_blockcompmaterial_2D[maxmeas];
-
-TGraphErrors* g_blockcompmaterial[maxmeas];
+std::vector<TGraphErrors*> g_blockcompmaterial;
 TCanvas* c_blockcompmaterial_g;
 TH2D* h_blockcompmaterial_g;
 TLegend* l_blockcompmaterial_g;
 
-TGraphErrors* g_blockcompmaterial2[maxmeas];
+std::vector<TGraphErrors*> g_blockcompmaterial2;
 TCanvas* c_blockcompmaterial_g2;
 TH2D* h_blockcompmaterial_g2;
 TLegend* l_blockcompmaterial_g2;
 
-TGraphErrors* g_gradcompmaterial[maxmeas];
+std::vector<TGraphErrors*> g_gradcompmaterial;
 TCanvas* c_gradcompmaterial;
 TH2D* h_gradcompmaterial;
 TLegend* l_gradcompmaterial;
@@ -399,227 +873,334 @@ TH2D* h_calicomp[sensors];
 
 
 // ********************
-// this function prepares the output file and all the roots
+// the number of roots booked so far
 // ********************
 
-void prepareroot()
+std::atomic<long int> bookedobjects(0);
+
+
+// ********************
+// this function sets up a canvas the way all our canvases look
+// ********************
+
+TCanvas* bookcanvas(const char* name, const char* title)
 {
+	TCanvas* acanvas = new TCanvas(name,title,600,400);
+	acanvas->SetGrid();
+	acanvas->SetFillColor(0);
+	acanvas->SetBorderMode(0);
+	acanvas->SetBorderSize(2);
+	acanvas->SetFrameBorderMode(0);
+	acanvas->SetFrameBorderMode(0);
+	bookedobjects++;
+	return acanvas;
+}
+
+
+// ********************
+// this function sets up a legend the way all our legends look
+// ********************
+
+TLegend* booklegend()
+{
+	TLegend* alegend = new TLegend(0.7,0.1,0.9,0.3);
+	alegend->SetBorderSize(1);
+	alegend->SetFillColor(0);
+	alegend->SetFillStyle(1);
+	bookedobjects++;
+	return alegend;
+}
 
-	if (debug<5)
-	{
-		cout << " " << endl;
-		cout << "********************" << endl;
-		cout << "Booking ROOTs!" << endl;
-		cout << "********************" << endl;
-		cout << " " << endl;
-	}
 
-	// first all roots for each individual measurement
+// ********************
+// this function paints a canvas once all graphs are on it, writes it and saves it as images if requested
+// ********************
 
-	// loop over the max number of measurements
-	for (int ii=0;ii<maxmeas;ii++)
+void closecanvas(TCanvas* acanvas)
+{
+	acanvas->Update();
+	acanvas->Write();
+	if (exportformats != "")
 	{
+		// the canvas name, without characters a file name should not have
+		std::string name = acanvas->GetName();
+		std::replace(name.begin(), name.end(), ' ', '_');
+		std::replace(name.begin(), name.end(), '/', '_');
+		std::string formats = exportformats;
+		size_t pos = 0;
+		while (!formats.empty())
+		{
+			pos = formats.find(",");
+			std::string format = formats.substr(0, pos);
+			formats.erase(0, pos == std::string::npos ? formats.size() : pos + 1);
+			if (format != "")
+			{
+				acanvas->SaveAs((exportdir + "/" + name + "." + format).c_str());
+			}
+		}
+	}
+	acanvas->Close();
+}
 
-		// a char for naming things
-		char tempchar[100];
 
-		// calibration canvas
-		sprintf(tempchar, "c_cali%i", ii);
-		c_cali[ii] = new TCanvas(tempchar,"Calibrations",600,400);
-		c_cali[ii]->SetGrid();
-		c_cali[ii]->SetFillColor(0);
-		c_cali[ii]->SetBorderMode(0);
-		c_cali[ii]->SetBorderSize(2);
-		c_cali[ii]->SetFrameBorderMode(0);
-		c_cali[ii]->SetFrameBorderMode(0);
+// ********************
+// this function books the graphs a measurement fills while looping its tuple
+// only the stages the mode runs are booked, the graphs for single calibrations are booked when a calibration is found
+// ********************
+
+void bookrun(int ii)
+{
 
+	// mode selection, 1 = calibration, 3 = calibration and analysis
+	if (mode == 1 || mode == 3)
+	{
 		// graph for the average calibration in a measurement run
 		avg_calibrationgraph[ii] = new TGraphErrors();
+		bookedobjects++;
+	}
 
-		// the histogram for calibrations
-		sprintf(tempchar, "h_cali%i", ii);
-		h_cali[ii]= new TH2D(tempchar,"Calibrations", 9 , -0.5, 9.5, 100 , -10 , 10);
-		h_cali[ii]->SetXTitle("Sensor");
-		h_cali[ii]->SetYTitle("Calibration [#circC]");
-		h_cali[ii]->SetStats(0000);
-
-		// the legend for calibrations
-		l_cali[ii] = new TLegend(0.7,0.1,0.9,0.3);
-		l_cali[ii]->SetBorderSize(1);
-		l_cali[ii]->SetFillColor(0);
-		l_cali[ii]->SetFillStyle(1);
-
-
-		// the canvas for temperatures
-		sprintf(tempchar, "c_temps%i", ii);
-		c_temps[ii]= new TCanvas(tempchar,"Temperatures",600,400);
-		c_temps[ii]->SetGrid();
-		c_temps[ii]->SetFillColor(0);
-		c_temps[ii]->SetBorderMode(0);
-		c_temps[ii]->SetBorderSize(2);
-		c_temps[ii]->SetFrameBorderMode(0);
-		c_temps[ii]->SetFrameBorderMode(0);
-
-		// the histogram for temperatures
-		sprintf(tempchar, "h_temps%i", ii);
-		h_temps[ii] = new TH2D(tempchar,"Temperatures", 100 , 0, 120000, 100 , -10 , 50);
-		h_temps[ii]->SetXTitle("Time [s]");
-		h_temps[ii]->SetYTitle("Temperature [#circC]");
-		h_temps[ii]->SetStats(0000);
-
-		// the legend for temperatures
-		l_temps[ii] = new TLegend(0.7,0.1,0.9,0.3);
-		l_temps[ii]->SetBorderSize(1);
-		l_temps[ii]->SetFillColor(0);
-		l_temps[ii]->SetFillStyle(1);
-
-
-		// the canvas for delta temperatures
-		sprintf(tempchar, "c_deltatemps%i", ii);
-		c_deltatemps[ii] = new TCanvas(tempchar,"Delta Temperatures",600,400);
-		c_deltatemps[ii]->SetGrid();
-		c_deltatemps[ii]->SetFillColor(0);
-		c_deltatemps[ii]->SetBorderMode(0);
-		c_deltatemps[ii]->SetBorderSize(2);
-		c_deltatemps[ii]->SetFrameBorderMode(0);
-		c_deltatemps[ii]->SetFrameBorderMode(0);
-
-		// the histogram for delta temperatures
-		sprintf(tempchar, "h_deltatemps%i", ii);
-		h_deltatemps[ii] = new TH2D(tempchar,"Delta Temperatures", 100 , 0, 120000, 100 , -10 , 10);
-		h_deltatemps[ii]->SetXTitle("Time [s]");
-		h_deltatemps[ii]->SetYTitle("Delta Temperature [#circC]");
-		h_deltatemps[ii]->SetStats(0000);
-
-		// the legend for delta temperatures
-		l_deltatemps[ii] = new TLegend(0.7,0.1,0.9,0.3);
-		l_deltatemps[ii]->SetBorderSize(1);
-		l_deltatemps[ii]->SetFillColor(0);
-		l_deltatemps[ii]->SetFillStyle(1);
-
-
-		// the canvas for gradients
-		sprintf(tempchar, "c_gradtemps%i", ii);
-		c_gradtemps[ii] = new TCanvas(tempchar,"Temperature Gradients",600,400);
-		c_gradtemps[ii]->SetGrid();
-		c_gradtemps[ii]->SetFillColor(0);
-		c_gradtemps[ii]->SetBorderMode(0);
-		c_gradtemps[ii]->SetBorderSize(2);
-		c_gradtemps[ii]->SetFrameBorderMode(0);
-		c_gradtemps[ii]->SetFrameBorderMode(0);
-
-		// the histogram for gradients
-		sprintf(tempchar, "h_gradtemps%i", ii);
-		h_gradtemps[ii] = new TH2D(tempchar,"Temperature Gradients", 100 , 0, 80, 100 , -10 , 50);
-		h_gradtemps[ii]->SetXTitle("Sensor Position [mm]");
-		h_gradtemps[ii]->SetYTitle("Temperature [#circC]");
-		h_gradtemps[ii]->SetStats(0000);
-
-		// the legend for gradients
-		l_gradtemps[ii] = new TLegend(0.7,0.1,0.9,0.3);
-		l_gradtemps[ii]->SetBorderSize(1);
-		l_gradtemps[ii]->SetFillColor(0);
-		l_gradtemps[ii]->SetFillStyle(1);
-
-		// the histogram for the difference between blocks
-		sprintf(tempchar, "h_blockdifference%i", ii);
-		h_blockdifference[ii] = new TH1D(tempchar,"Block Temperature Differences", 1000, -5, 10);
-		h_blockdifference[ii]->SetXTitle("Temperature Difference [#circC]");
-		h_blockdifference[ii]->SetYTitle("Entries");
-		h_blockdifference[ii]->SetStats(1111);
-
-
-		// the graphs for the individual calibrations
-		for (int i=0;i<maxcalibs;i++)
-		{
-			calibrationgraph[ii][i] = new TGraphErrors();
-			caliposition[ii][i] = new TLine();
-		}
-
-
+	// mode selection, 2 = analysis, 3 = calibration and analysis
+	if (mode == 2 || mode == 3)
+	{
 		// the graphs for the temperatures and delta temperatures of each individual sensor
 		for (int i=0;i<sensors;i++)
 		{
-			tempgraph[ii][i] = new TGraphErrors();
-			deltatempgraph[ii][i] = new TGraphErrors();
+			tempgraph[ii].push_back(new TGraphErrors());
+			deltatempgraph[ii].push_back(new TGraphErrors());
+			bookedobjects += 2;
 		}
+	}
 
+}
 
-		// the graphs for each gradient measurement point
-		for (int i=0;i<maxstable;i++)
-		{
-			gradgraph[ii][i] = new TGraphErrors();
-			sprintf(tempchar, "fitlow%i%i", ii,i);
-			gradfit1[ii][i] = new TF1(tempchar, "pol1", 0.0, 40.1);
-			sprintf(tempchar, "fithigh%i%i", ii,i);
-			gradfit2[ii][i] = new TF1(tempchar, "pol1", 39.9, 80.0);
-			gradposition[ii][i] = new TLine();
-		}
 
-	} // done measurement loop
+// ********************
+// this function books the canvas of the calibrations of a measurement, once it is plotted
+// ********************
 
-	if (debug<2)
+void bookcalibrationplot(int ii)
+{
+
+	// a char for naming things
+	char tempchar[100];
+
+	// the graph of each calibration
+	for (int j=0;j<results[ii].calibs;j++)
 	{
-		cout << "Done booking in measurement loop!" << endl;
+		calibrationgraph[ii].push_back(new TGraphErrors());
+		sprintf(tempchar, "calibration%i", j);
+		calibrationgraph[ii][j]->SetName(tempchar);
+		bookedobjects++;
 	}
+	avg_calibrationgraph[ii]->SetName("calibration average");
 
-	// now plots for comparisons between measurements
-
-	// for each thickness...
-	for (int i=0;i<thicknesscount;i++)
+	// nothing to draw on
+	if (headless == 1)
 	{
+		return;
+	}
 
-		// a char for naming things
-		char tempchar[100];
+	// calibration canvas
+	sprintf(tempchar, "c_cali%i", ii);
+	c_cali[ii] = bookcanvas(tempchar,"Calibrations");
 
-		// calibrations
-		sprintf(tempchar, "Calibrations at thickness %i", thicknesslist.at(i));
-		c_calicompthick[i] = new TCanvas(tempchar,"Calibrations",600,400);
-		c_calicompthick[i]->SetGrid();
-		c_calicompthick[i]->SetFillColor(0);
-		c_calicompthick[i]->SetBorderMode(0);
-		c_calicompthick[i]->SetBorderSize(2);
-		c_calicompthick[i]->SetFrameBorderMode(0);
-		c_calicompthick[i]->SetFrameBorderMode(0);
+	// the frame for calibrations, it stays empty
+	sprintf(tempchar, "h_cali%i", ii);
+	h_cali[ii]= new TH2D(tempchar,"Calibrations", 1 , -0.5, 9.5, 1 , -10 , 10);
+	h_cali[ii]->SetXTitle("Sensor");
+	h_cali[ii]->SetYTitle("Calibration [#circC]");
+	h_cali[ii]->SetStats(0000);
+	bookedobjects++;
 
-		h_calicompthick[i]= new TH2D(tempchar,"Calibrations", 9 , -0.5, 9.5, 100 , -10 , 10);
-		h_calicompthick[i]->SetXTitle("Sensor");
-		h_calicompthick[i]->SetYTitle("Calibration [#circC]");
-		h_calicompthick[i]->SetStats(0000);
+	// the legend for calibrations
+	l_cali[ii] = booklegend();
 
-		l_calicompthick[i] = new TLegend(0.7,0.1,0.9,0.3);
-		l_calicompthick[i]->SetBorderSize(1);
-		l_calicompthick[i]->SetFillColor(0);
-		l_calicompthick[i]->SetFillStyle(1);
+}
 
 
-		// block temperature differences
-		sprintf(tempchar, "Block temperature difference at thickness %i", thicknesslist.at(i));
-		c_blockcompthick[i] = new TCanvas(tempchar,"Block temperature difference",600,400);
-		c_blockcompthick[i]->SetGrid();
-		c_blockcompthick[i]->SetFillColor(0);
-		c_blockcompthick[i]->SetBorderMode(0);
-		c_blockcompthick[i]->SetBorderSize(2);
-		c_blockcompthick[i]->SetFrameBorderMode(0);
-		c_blockcompthick[i]->SetFrameBorderMode(0);
+// ********************
+// this function books the canvases, lines and fits of the analysis of a measurement, once it is plotted
+// ********************
 
-		h_blockcompthick[i]= new TH1D(tempchar,"Block temperature difference", 1000, -5, 10);
-		h_blockcompthick[i]->SetXTitle("Temperature [#circC]");
-		h_blockcompthick[i]->SetYTitle("Entries");
-		h_blockcompthick[i]->SetStats(0000);
+void bookanalysisplot(int ii)
+{
 
-		l_blockcompthick[i] = new TLegend(0.7,0.1,0.9,0.3);
-		l_blockcompthick[i]->SetBorderSize(1);
-		l_blockcompthick[i]->SetFillColor(0);
-		l_blockcompthick[i]->SetFillStyle(1);
+	// a char for naming things
+	char tempchar[100];
 
+	// the histogram for the difference between blocks
+	sprintf(tempchar, "h_blockdifference%i", ii);
+	h_blockdifference[ii] = new TH1D(tempchar,"Block Temperature Differences", 1000, -5, 10);
+	h_blockdifference[ii]->SetXTitle("Temperature Difference [#circC]");
+	h_blockdifference[ii]->SetYTitle("Entries");
+	h_blockdifference[ii]->SetStats(1111);
+	bookedobjects++;
+
+	// the graphs for each gradient measurement point found
+	for (int i=0;i<results[ii].stablepoints;i++)
+	{
+		gradgraph[ii].push_back(new TGraphErrors());
+		sprintf(tempchar, "gradient%i", i);
+		gradgraph[ii][i]->SetName(tempchar);
+		sprintf(tempchar, "fitlow%i%i", ii,i);
+		gradfit1[ii].push_back(new TF1(tempchar, "pol1", 0.0, 40.1));
+		sprintf(tempchar, "fithigh%i%i", ii,i);
+		gradfit2[ii].push_back(new TF1(tempchar, "pol1", 39.9, 80.0));
+		bookedobjects += 3;
+	}
+
+	// the time graphs are booked with the run
+	for (int j=0;j<sensors;j++)
+	{
+		sprintf(tempchar, "temperature%i", j);
+		tempgraph[ii][j]->SetName(tempchar);
+		sprintf(tempchar, "deltatemperature%i", j);
+		deltatempgraph[ii][j]->SetName(tempchar);
+	}
+
+	// nothing to draw on
+	if (headless == 1)
+	{
+		return;
+	}
+
+	// the frames stay empty, they are only drawn for their axes and are written with each canvas, so they have a single bin
+
+	// the canvas for temperatures
+	sprintf(tempchar, "c_temps%i", ii);
+	c_temps[ii]= bookcanvas(tempchar,"Temperatures");
+
+	// the histogram for temperatures
+	sprintf(tempchar, "h_temps%i", ii);
+	h_temps[ii] = new TH2D(tempchar,"Temperatures", 1 , 0, 120000, 1 , -10 , 50);
+	h_temps[ii]->SetXTitle("Time [s]");
+	h_temps[ii]->SetYTitle("Temperature [#circC]");
+	h_temps[ii]->SetStats(0000);
+	bookedobjects++;
+
+	// the legend for temperatures
+	l_temps[ii] = booklegend();
+
+
+	// the canvas for delta temperatures
+	sprintf(tempchar, "c_deltatemps%i", ii);
+	c_deltatemps[ii] = bookcanvas(tempchar,"Delta Temperatures");
+
+	// the histogram for delta temperatures
+	sprintf(tempchar, "h_deltatemps%i", ii);
+	h_deltatemps[ii] = new TH2D(tempchar,"Delta Temperatures", 1 , 0, 120000, 1 , -10 , 10);
+	h_deltatemps[ii]->SetXTitle("Time [s]");
+	h_deltatemps[ii]->SetYTitle("Delta Temperature [#circC]");
+	h_deltatemps[ii]->SetStats(0000);
+	bookedobjects++;
+
+	// the legend for delta temperatures
+	l_deltatemps[ii] = booklegend();
+
+
+	// the canvas for gradients
+	sprintf(tempchar, "c_gradtemps%i", ii);
+	c_gradtemps[ii] = bookcanvas(tempchar,"Temperature Gradients");
+
+	// the histogram for gradients
+	sprintf(tempchar, "h_gradtemps%i", ii);
+	h_gradtemps[ii] = new TH2D(tempchar,"Temperature Gradients", 1 , 0, 80, 1 , -10 , 50);
+	h_gradtemps[ii]->SetXTitle("Sensor Position [mm]");
+	h_gradtemps[ii]->SetYTitle("Temperature [#circC]");
+	h_gradtemps[ii]->SetStats(0000);
+	bookedobjects++;
+
+	// the legend for gradients
+	l_gradtemps[ii] = booklegend();
+
+
+	// the lines for the calibrations found
+	for (int i=0;i<results[ii].calibs;i++)
+	{
+		caliposition[ii].push_back(new TLine());
+		bookedobjects++;
+	}
+
+
+	// the lines for each gradient measurement point found
+	for (int i=0;i<results[ii].stablepoints;i++)
+	{
+		gradposition[ii].push_back(new TLine());
+		bookedobjects++;
+	}
+
+}
+
+
+// ********************
+// this function prepares the output file and all the roots
+// ********************
+
+void prepareroot()
+{
+
+	if (debug<5)
+	{
+		cout << " " << endl;
+		cout << "********************" << endl;
+		cout << "Booking ROOTs!" << endl;
+		cout << "********************" << endl;
+		cout << " " << endl;
 	}
 
+	// first all roots for each individual measurement in the runlist
+
+	// one slot per run for each root
+	unsigned int runs = filelist.size();
+	calibrationgraph.resize(runs);
+	caliposition.resize(runs);
+	avg_calibrationgraph.resize(runs, 0);
+	c_cali.resize(runs, 0);
+	h_cali.resize(runs, 0);
+	l_cali.resize(runs, 0);
+	tempgraph.resize(runs);
+	deltatempgraph.resize(runs);
+	c_temps.resize(runs, 0);
+	h_temps.resize(runs, 0);
+	l_temps.resize(runs, 0);
+	c_deltatemps.resize(runs, 0);
+	h_deltatemps.resize(runs, 0);
+	l_deltatemps.resize(runs, 0);
+	gradgraph.resize(runs);
+	gradfit1.resize(runs);
+	gradfit2.resize(runs);
+	gradposition.resize(runs);
+	c_gradtemps.resize(runs, 0);
+	h_gradtemps.resize(runs, 0);
+	l_gradtemps.resize(runs, 0);
+	h_blockdifference.resize(runs, 0);
+	profiles.resize(runs);
+
+	// loop over the measurements
+	for (unsigned int ii=0;ii<runs;ii++)
+	{
+		if (runplotted(ii))
+		{
+			long int booked = bookedobjects;
+			bookrun(ii);
+			profiles.at(ii).objects += bookedobjects - booked;
+		}
+	} // done measurement loop
+
 	if (debug<2)
 	{
-		cout << "Done thickness loop!" << endl;
+		cout << "Done booking in measurement loop!" << endl;
 	}
 
+	// now plots for comparisons between measurements
+
+	// one slot per material
+	h_blockcompmaterial.resize(materialcount, 0);
+	h_blockcompmaterial_2D.resize(materialcount, 0);
+	g_blockcompmaterial.resize(materialcount, 0);
+	g_blockcompmaterial2.resize(materialcount, 0);
+	g_gradcompmaterial.resize(materialcount, 0);
+
 	// for each material...
 	for (int i=0;i<materialcount;i++)
 	{
@@ -627,47 +1208,13 @@ void prepareroot()
 		// a char for naming things
 		char tempchar[100];
 
-		// calibrations
-		sprintf(tempchar, "Calibrations of material %s", materiallist.at(i).c_str());
-		c_calicompmaterial[i] = new TCanvas(tempchar,"Calibrations",600,400);
-		c_calicompmaterial[i]->SetGrid();
-		c_calicompmaterial[i]->SetFillColor(0);
-		c_calicompmaterial[i]->SetBorderMode(0);
-		c_calicompmaterial[i]->SetBorderSize(2);
-		c_calicompmaterial[i]->SetFrameBorderMode(0);
-		c_calicompmaterial[i]->SetFrameBorderMode(0);
-
-		h_calicompmaterial[i]= new TH2D(tempchar,"Calibrations", 9 , -0.5, 9.5, 100 , -10 , 10);
-		h_calicompmaterial[i]->SetXTitle("Sensor");
-		h_calicompmaterial[i]->SetYTitle("Calibration [#circC]");
-		h_calicompmaterial[i]->SetStats(0000);
-
-		l_calicompmaterial[i] = new TLegend(0.7,0.1,0.9,0.3);
-		l_calicompmaterial[i]->SetBorderSize(1);
-		l_calicompmaterial[i]->SetFillColor(0);
-		l_calicompmaterial[i]->SetFillStyle(1);
-
-
 		// block temperature differences
 		sprintf(tempchar, "Block temperature difference for material %s", materiallist.at(i).c_str());
-		c_blockcompmaterial[i] = new TCanvas(tempchar,tempchar,600,400);
-		c_blockcompmaterial[i]->SetGrid();
-		c_blockcompmaterial[i]->SetFillColor(0);
-		c_blockcompmaterial[i]->SetBorderMode(0);
-		c_blockcompmaterial[i]->SetBorderSize(2);
-		c_blockcompmaterial[i]->SetFrameBorderMode(0);
-		c_blockcompmaterial[i]->SetFrameBorderMode(0);
-
 		h_blockcompmaterial[i]= new TH1D(tempchar,tempchar, 1000, -5, 10);
 		h_blockcompmaterial[i]->SetXTitle("Temperature [#circC]");
 		h_blockcompmaterial[i]->SetYTitle("Entries");
 		h_blockcompmaterial[i]->SetStats(1111);
 
-		l_blockcompmaterial[i] = new TLegend(0.7,0.1,0.9,0.3);
-		l_blockcompmaterial[i]->SetBorderSize(1);
-		l_blockcompmaterial[i]->SetFillColor(0);
-		l_blockcompmaterial[i]->SetFillStyle(1);
-
 		sprintf(tempchar, "Block temperature difference for material %s vs temperature", materiallist.at(i).c_str());
 		h_blockcompmaterial_2D[i]= new TH2D(tempchar,tempchar, 100, 0, 30, 1000, -5, 10);
 		h_blockcompmaterial_2D[i]->SetXTitle("Measurement Temperature [#circC]");
@@ -679,6 +1226,8 @@ void prepareroot()
 
 		g_gradcompmaterial[i] = new TGraphErrors();
 
+		bookedobjects += 5;
+
 	} // done material loop
 
 	if (debug<2)
@@ -686,69 +1235,58 @@ void prepareroot()
 		cout << "Done booking in material loop!" << endl;
 	}
 
+	// name the comparison graphs, they are written as they are without canvases
+	for (int i=0;i<materialcount;i++)
+	{
+		g_blockcompmaterial[i]->SetName("Block temperature differences");
+		g_blockcompmaterial2[i]->SetName("Block temperature differences vs slope");
+		g_gradcompmaterial[i]->SetName("Gradient differences");
+	}
+
 	char tempchar[100];
 
-	// an overall comparison
-	sprintf(tempchar, "Block temperature differences");
-	c_blockcompmaterial_g = new TCanvas(tempchar,tempchar,600,400);
-	c_blockcompmaterial_g->SetGrid();
-	c_blockcompmaterial_g->SetFillColor(0);
-	c_blockcompmaterial_g->SetBorderMode(0);
-	c_blockcompmaterial_g->SetBorderSize(2);
-	c_blockcompmaterial_g->SetFrameBorderMode(0);
-	c_blockcompmaterial_g->SetFrameBorderMode(0);
-
-	h_blockcompmaterial_g = new TH2D(tempchar,tempchar, 1000, 0, 30, 1000, -5, 10);
-	h_blockcompmaterial_g->SetXTitle("Measurement Temperature [#circC]");
-	h_blockcompmaterial_g->SetYTitle("Temperature Difference [#circC]");
-	h_blockcompmaterial_g->SetStats(0000);
-
-	l_blockcompmaterial_g = new TLegend(0.7,0.1,0.9,0.3);
-	l_blockcompmaterial_g->SetBorderSize(1);
-	l_blockcompmaterial_g->SetFillColor(0);
-	l_blockcompmaterial_g->SetFillStyle(1);
-
-
-	// comparison vs slope
-	sprintf(tempchar, "Block temperature differences vs slope");
-	c_blockcompmaterial_g2 = new TCanvas(tempchar,tempchar,600,400);
-	c_blockcompmaterial_g2->SetGrid();
-	c_blockcompmaterial_g2->SetFillColor(0);
-	c_blockcompmaterial_g2->SetBorderMode(0);
-	c_blockcompmaterial_g2->SetBorderSize(2);
-	c_blockcompmaterial_g2->SetFrameBorderMode(0);
-	c_blockcompmaterial_g2->SetFrameBorderMode(0);
-
-	h_blockcompmaterial_g2 = new TH2D(tempchar,tempchar, 1000, -0.01, 0.05, 1000, -5, 10);
-	h_blockcompmaterial_g2->SetXTitle("Gradient Slope [#circC/mm]");
-	h_blockcompmaterial_g2->SetYTitle("Temperature Difference [#circC]");
-	h_blockcompmaterial_g2->SetStats(0000);
-
-	l_blockcompmaterial_g2 = new TLegend(0.7,0.1,0.9,0.3);
-	l_blockcompmaterial_g2->SetBorderSize(1);
-	l_blockcompmaterial_g2->SetFillColor(0);
-	l_blockcompmaterial_g2->SetFillStyle(1);
-
-
-	// an overall comparison of gradients
-	sprintf(tempchar, "Gradient differences");
-	c_gradcompmaterial = new TCanvas(tempchar,tempchar,600,400);
-	c_gradcompmaterial->SetGrid();
-	c_gradcompmaterial->SetFillColor(0);
-	c_gradcompmaterial->SetBorderMode(0);
-	c_gradcompmaterial->SetBorderSize(2);
-	c_gradcompmaterial->SetFrameBorderMode(0);
-	c_gradcompmaterial->SetFrameBorderMode(0);
-
-	h_gradcompmaterial = new TH2D(tempchar,tempchar, 1000, 0, 30, 1000, -0.01, 0.05);
-	h_gradcompmaterial->SetXTitle("Heat - Workpoint [#circC]");
-	h_gradcompmaterial->SetYTitle("Gradient Slope [#circC/mm]");
-	h_gradcompmaterial->SetStats(0000);
-
-	l_gradcompmaterial = new TLegend(0.7,0.1,0.9,0.3);
-	l_gradcompmaterial->SetBorderSize(1);
-	l_gradcompmaterial->SetFillColor(0);
-	l_gradcompmaterial->SetFillStyle(1);
+	// the frames of the comparisons, only to draw on, with a single bin
+	if (headless == 0)
+	{
+
+		// an overall comparison
+		sprintf(tempchar, "Block temperature differences");
+		c_blockcompmaterial_g = bookcanvas(tempchar,tempchar);
+
+		h_blockcompmaterial_g = new TH2D(tempchar,tempchar, 1, 0, 30, 1, -5, 10);
+		h_blockcompmaterial_g->SetXTitle("Measurement Temperature [#circC]");
+		h_blockcompmaterial_g->SetYTitle("Temperature Difference [#circC]");
+		h_blockcompmaterial_g->SetStats(0000);
+
+		l_blockcompmaterial_g = booklegend();
+
+
+		// comparison vs slope
+		sprintf(tempchar, "Block temperature differences vs slope");
+		c_blockcompmaterial_g2 = bookcanvas(tempchar,tempchar);
+
+		h_blockcompmaterial_g2 = new TH2D(tempchar,tempchar, 1, -0.01, 0.05, 1, -5, 10);
+		h_blockcompmaterial_g2->SetXTitle("Gradient Slope [#circC/mm]");
+		h_blockcompmaterial_g2->SetYTitle("Temperature Difference [#circC]");
+		h_blockcompmaterial_g2->SetStats(0000);
+
+		l_blockcompmaterial_g2 = booklegend();
+
+
+		// an overall comparison of gradients
+		sprintf(tempchar, "Gradient differences");
+		c_gradcompmaterial = bookcanvas(tempchar,tempchar);
+
+		h_gradcompmaterial = new TH2D(tempchar,tempchar, 1, 0, 30, 1, -0.01, 0.05);
+		h_gradcompmaterial->SetXTitle("Heat - Workpoint [#circC]");
+		h_gradcompmaterial->SetYTitle("Gradient Slope [#circC/mm]");
+		h_gradcompmaterial->SetStats(0000);
+
+		l_gradcompmaterial = booklegend();
+
+		bookedobjects += 3;
+
+	}
 
 	// an overall comparison for calibrations
 	for (int i=0;i<sensors;i++)
@@ -758,6 +1296,7 @@ void prepareroot()
 		h_calicomp[i]->SetXTitle("Measurement Temperature [#circC]");
 		h_calicomp[i]->SetYTitle("Calibration [#circC]");
 		h_calicomp[i]->SetStats(1111);
+		bookedobjects++;
 	}
 
 	if (debug<2)
@@ -768,1280 +1307,5329 @@ void prepareroot()
 
 
 // ********************
-// this function opens the individual root file
+// the column cache of the tuples
 // ********************
 
-void openfile(std::string myfile)
+// a cache file starts with this header and the path of its tuple, then come the columns:
+// uTime, temperature0 to temperature9, current1 and workingTemperature, 4 bytes per entry each
+struct cacheheader
 {
+	char magic[8];
+	int version;
+	int columns;
+	long long entries;
+	long long filesize;
+	long long mtime;
+	long long pathlength;
+	long long dataoffset;
+};
 
-	// the stream - check if file exists
-	ifstream fileRead;
+// the layout of the cache files
+const int cacheversion = 1;
+const int cachecolumns = sensors + 3;
 
-	// open
-	fileRead.open(myfile.c_str());
+// the cache files written so far, to give each one its own temporary name
+std::atomic<int> cachewrites(0);
 
-	if ( !fileRead.is_open() )
-	{
-		cout << "Error opening root file " << myfile << " !" << endl;
-		exit ( EXIT_FAILURE );
-	}
 
-	// close, let root do this
-	fileRead.close();
-  
-	// the file to open
-	TFile *f1;
-	f1 = TFile::Open(myfile.c_str());
+// ********************
+// this function returns the name of the cache file of a tuple
+// ********************
 
-	// enter the input file
-	f1->cd();
+std::string cachename(const std::string& myfile)
+{
+	std::ostringstream name;
+	name << cachedir << "/" << std::hex << std::hash<std::string>()(myfile) << ".thermocache";
+	return name.str();
+}
 
-	// go into the tree
-	mytuple = (TTree*)f1->Get("thermoDAQ");
 
-	// how many entries in this tuple?
-	tupleentrycount = mytuple->GetEntries();
-	if (debug<5)
+// ********************
+// this function maps the cache file of a tuple, if it is there and was written from the same file, size and modification time
+// ********************
+
+bool opencache(const std::string& myfile, runstate& state)
+{
+
+	struct stat tuplestat;
+	if (stat(myfile.c_str(), &tuplestat) != 0)
 	{
-		cout << " " << endl;
-		cout << "********************" << endl;
-		cout << "Looping "<< tupleentrycount << " entries in the input file " << myfile.c_str() << " ..." << endl;
-		cout << "********************" << endl;
-		cout << " " << endl;
+		return false;
 	}
 
-	// ********************
-	// connect branch and variable
-	// ********************
+	int fd = open(cachename(myfile).c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat cachestat;
+	if (fstat(fd, &cachestat) != 0 || cachestat.st_size < (off_t)sizeof(cacheheader))
+	{
+		close(fd);
+		return false;
+	}
+	void* map = mmap(0, cachestat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		return false;
+	}
 
-	// the time
-	mytuple->SetBranchAddress("uTime", &uTime);
+	// does it belong to this tuple?
+	const cacheheader* header = (const cacheheader*)map;
+	const char* base = (const char*)map;
+	bool valid = memcmp(header->magic, "THERMOC", 8) == 0 && header->version == cacheversion && header->columns == cachecolumns;
+	valid = valid && header->filesize == (long long)tuplestat.st_size && header->mtime == (long long)tuplestat.st_mtime;
+	valid = valid && header->pathlength == (long long)myfile.size() && (long long)sizeof(cacheheader) + header->pathlength <= header->dataoffset;
+	valid = valid && header->dataoffset + (long long)cachecolumns*header->entries*4 <= (long long)cachestat.st_size;
+	valid = valid && memcmp(base + sizeof(cacheheader), myfile.c_str(), myfile.size()) == 0;
+	if (!valid)
+	{
+		munmap(map, cachestat.st_size);
+		return false;
+	}
 
-	// the temperatures of the sensors
-	for (int row = 0; row < 10; ++row)
+	state.cachemap = map;
+	state.cachemapsize = cachestat.st_size;
+	state.tupleentrycount = header->entries;
+	const char* column = base + header->dataoffset;
+	state.cachetime = (const unsigned int*)column;
+	for (int j=0;j<sensors;j++)
 	{
-		mytuple->SetBranchAddress(Form("temperature%d", row), &temperature[row]);
+		state.cachetemperature[j] = (const float*)(column + (1 + j)*header->entries*4);
 	}
+	state.cachecurrent = (const float*)(column + (1 + sensors)*header->entries*4);
+	state.cacheworking = (const float*)(column + (2 + sensors)*header->entries*4);
 
-	// the current
-	mytuple->SetBranchAddress("current1", &current1);
+	// the next read of each page is from memory
+	madvise(map, cachestat.st_size, MADV_SEQUENTIAL);
 
-	// the working temperature
-	mytuple->SetBranchAddress("workingTemperature", &workingTemperature);
+	return true;
 
 }
 
 
 // ********************
-// read the runlist - this opens the runlist and gets the tuple names and other infos for plotting
+// this function reads the used branches of a tuple once with root and writes them into its cache file
 // ********************
 
-void readrunlist(std::string astring)
+void buildcache(const std::string& myfile, runstate& state)
 {
-	// the stream
-	ifstream fileRead;
-
-	// open
-	fileRead.open(astring.c_str());
 
-	if ( !fileRead.is_open() )
+	struct stat tuplestat;
+	if (stat(myfile.c_str(), &tuplestat) != 0)
 	{
-		cout << "Error opening runlist file " << astring << " !" << endl;
+		cout << "Error opening root file " << myfile << " !" << endl;
 		exit ( EXIT_FAILURE );
 	}
 
-	// the line to read
-	std::string line;
-
-	// a counter
-	int linecount = 0;
-
-	if (debug<5)
+	TFile* afile = TFile::Open(myfile.c_str());
+	if (afile == 0 || afile->IsZombie())
 	{
-		cout << " " << endl;
-		cout << "********************" << endl;
-		cout << "Reading runlist!" << endl;
-		cout << "********************" << endl;
-		cout << " " << endl;
+		cout << "Error opening root file " << myfile << " !" << endl;
+		exit ( EXIT_FAILURE );
 	}
-
-	int filecounter = 0;
-
-	// loop over the lines in the file
-	while (std::getline(fileRead, line))
+	TTree* atuple = (TTree*)afile->Get("thermoDAQ");
+	if (atuple == 0)
+	{
+		cout << "Error reading the tuple of " << myfile << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	long long entries = atuple->GetEntries();
+
+	// the branches by sensor number, not sorted
+	unsigned int uTime = 0;
+	float temperature[sensors];
+	float current1 = 0.0;
+	float workingTemperature = 0.0;
+	atuple->SetBranchStatus("*", 0);
+	atuple->SetCacheSize(maxcachesize);
+	atuple->SetBranchStatus("uTime", 1);
+	atuple->SetBranchAddress("uTime", &uTime);
+	atuple->AddBranchToCache("uTime");
+	for (int j=0;j<sensors;j++)
+	{
+		temperature[j] = 0.0;
+		atuple->SetBranchStatus(Form("temperature%d", j), 1);
+		atuple->SetBranchAddress(Form("temperature%d", j), &temperature[j]);
+		atuple->AddBranchToCache(Form("temperature%d", j));
+	}
+	atuple->SetBranchStatus("current1", 1);
+	atuple->SetBranchAddress("current1", &current1);
+	atuple->AddBranchToCache("current1");
+	atuple->SetBranchStatus("workingTemperature", 1);
+	atuple->SetBranchAddress("workingTemperature", &workingTemperature);
+	atuple->AddBranchToCache("workingTemperature");
+	atuple->StopCacheLearningPhase();
+
+	// write next to the cache file and move it there when done, so nobody maps a half written cache
+	// runs of the same tuple in other threads write their own temporary file
+	char tempchar[100];
+	sprintf(tempchar, ".%i.%i.tmp", (int)getpid(), (int)cachewrites++);
+	std::string name = cachename(myfile);
+	std::string tempname = name + tempchar;
+	int fd = open(tempname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
 	{
+		cout << "Error writing the column cache " << tempname << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
 
-		// comment lines start with #
-		string startpart = line.substr(0,1);
-		if (startpart != "#")
+	cacheheader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "THERMOC", 8);
+	header.version = cacheversion;
+	header.columns = cachecolumns;
+	header.entries = entries;
+	header.filesize = tuplestat.st_size;
+	header.mtime = tuplestat.st_mtime;
+	header.pathlength = myfile.size();
+	header.dataoffset = ((sizeof(cacheheader) + myfile.size())/64 + 1)*64;
+
+	// the columns are written in blocks of entries
+	const long long block = 65536;
+	std::vector<unsigned int> timeblock(block);
+	std::vector<float> valueblock[cachecolumns];
+	for (int c=1;c<cachecolumns;c++)
+	{
+		valueblock[c].resize(block);
+	}
+	bool good = true;
+	for (long long start=0;start<entries;start+=block)
+	{
+		long long n = std::min(block, entries - start);
+		for (long long k=0;k<n;k++)
 		{
-
-			// dummy string
-			std::string fail;
-
-			// the input string of this line
-			std::string input;
-			std::istringstream iss(line);
-			input = iss.str();
-
-			// the delimiter of the comments (space)
-			std::string delimiter = ",";
-
-			// the position we found of the delimiter
-			size_t pos = 0;
-
-			// the iterator for counting elements
-			std::vector<int>::iterator it;
-
-			// string iterator
-			std::vector<string>::iterator its;
-
-			// first the filename
-			pos = input.find(delimiter);
-			fail = input.substr(0, pos);
-			input.erase(0, pos + delimiter.length());
-
-			// push the name into the vector
-			filelist.push_back(fail);
-
-			if (debug<4)
-			{
-				cout << "Found file no: " << filecounter << " : " << fail << " !" << endl;
-			}
-
-			// nameing starts at 0
-			filecounter++;
-
-			// the sensor sorting
-			pos = input.find(delimiter);
-			fail = input.substr(0, pos);
-			input.erase(0, pos + delimiter.length());
-
-			// push the name into the vector
-			sensorsort.push_back(fail.c_str());
-
-			if (debug<4)
-			{
-				cout << "Found sensor sorting: " << fail << " !" << endl;
-			}
-			
-			// the sensor sorting
-			pos = input.find(delimiter);
-			fail = input.substr(0, pos);
-			input.erase(0, pos + delimiter.length());
-
-			// push the name into the vector
-			brokenlist.push_back(fail.c_str());
-
-			if (debug<4)
-			{
-				cout << "Found broken sensor: " << fail << " !" << endl;
-			}
-
-			// the material thickness
-			pos = input.find(delimiter);
-			fail = input.substr(0, pos);
-			input.erase(0, pos + delimiter.length());
-
-			// push the name into the vector
-			thickness.push_back(atoi(fail.c_str()));
-
-			if (debug<4)
-			{
-				cout << "Found thickness: " << fail << " !" << endl;
-			}
-
-			// sort thicknesses
-			it = find (thicknesslist.begin(), thicknesslist.end(), atoi(fail.c_str()));
-			if (it != thicknesslist.end())
-			{
-				if (debug <1)
-				{
-					cout << "Thickness " << fail << " already in list!" << endl;
-				}
-			} else {
-				thicknesscount++;
-				thicknesslist.push_back(atoi(fail.c_str()));
-				if (debug <2)
-				{
-					cout << "Thickness " << fail << " not in list! Total thicknesses now " << thicknesscount << endl;
-				}
-			}
-
-			// the material type
-			pos = input.find(delimiter);
-			fail = input.substr(0, pos);
-			input.erase(0, pos + delimiter.length());
-
-			// push the name into the vector
-			material.push_back(fail);
-
-			if (debug<4)
+			int bytes = atuple->GetEntry(start + k);
+			if (bytes > 0)
 			{
-				cout << "Found material: " << fail << " !" << endl;
+				state.bytesunzipped += bytes;
 			}
-
-			// sort materials
-			its = find (materiallist.begin(), materiallist.end(), fail);
-			if (its != materiallist.end())
+			timeblock[k] = uTime;
+			for (int j=0;j<sensors;j++)
 			{
-				if (debug <1)
-				{
-					cout << "Material " << fail << " already in list!" << endl;
-				}
-			} else {
-				materialcount++;
-				materiallist.push_back(fail);
-				if (debug <2)
-				{
-					cout << "Material " << fail << " not in list! Total materials now " << materialcount << endl;
-				}
+				valueblock[1 + j][k] = temperature[j];
 			}
+			valueblock[1 + sensors][k] = current1;
+			valueblock[2 + sensors][k] = workingTemperature;
+		}
+		good = good && pwrite(fd, &timeblock[0], n*4, header.dataoffset + start*4) == n*4;
+		for (int c=1;c<cachecolumns;c++)
+		{
+			good = good && pwrite(fd, &valueblock[c][0], n*4, header.dataoffset + (c*entries + start)*4) == n*4;
+		}
+	}
+	good = good && pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+	good = good && pwrite(fd, myfile.c_str(), myfile.size(), sizeof(header)) == (ssize_t)myfile.size();
+	good = good && ftruncate(fd, header.dataoffset + (long long)cachecolumns*entries*4) == 0;
+	close(fd);
+	if (!good || rename(tempname.c_str(), name.c_str()) != 0)
+	{
+		unlink(tempname.c_str());
 
-			// comments
-			pos = input.find(delimiter);
-			fail = input.substr(0, pos);
-			input.erase(0, pos + delimiter.length());
+		// another run of the same tuple may have put a valid cache there first
+		runstate other;
+		if (!good || !opencache(myfile, other))
+		{
+			cout << "Error writing the column cache " << name << " !" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		munmap(other.cachemap, other.cachemapsize);
+	}
 
-			// push the name into the vector
-			comments.push_back(fail);
+	state.bytesread += afile->GetBytesRead();
+	afile->Close();
+	delete afile;
 
-			if (debug<4)
-			{
-				cout << "Found comment: " << fail << " !" << endl;
-				cout << " " << endl;
-			}
+	if (debug<4)
+	{
+		state.messages << "Wrote " << entries << " entries of " << myfile << " into the column cache " << name << " !" << endl;
+		state.messages << " " << endl;
+	}
 
-			linecount++;
+}
 
-		} // done no comment line
 
-	} // done while reading
+// ********************
+// this function checks a block of time stamps: it counts the gaps in the daq, the repeated time stamps and the ones going back
+// the steps are compared without branches, so the loop is vectorised
+// ********************
 
-	fileRead.close();
+void checktimes(runclock& clock, const unsigned int* times, size_t n)
+{
+	if (n == 0)
+	{
+		return;
+	}
+	if (clock.entries == 0)
+	{
+		clock.first = times[0];
+		clock.last = times[0];
+	}
 
-	if (linecount>maxmeas)
+	long int gaps = 0;
+	long int duplicates = 0;
+	long int backwards = 0;
+	unsigned int longest = 0;
+	unsigned int previous = clock.last;
+	size_t start = (clock.entries == 0) ? 1 : 0;
+	if (start == 0)
+	{
+		unsigned int step = (times[0] > previous) ? times[0] - previous : 0;
+		gaps += (step > daqgap);
+		duplicates += (times[0] == previous);
+		backwards += (times[0] < previous);
+		longest = step;
+		start = 1;
+	}
+	for (size_t i=start;i<n;i++)
 	{
-		cout << "Warning: found " << linecount << " measurements in the runlist. Increase maxmeas from " << maxmeas << " to " << linecount << " to analyse all runs!" << endl;
+		unsigned int step = (times[i] > times[i-1]) ? times[i] - times[i-1] : 0;
+		gaps += (step > daqgap);
+		duplicates += (times[i] == times[i-1]);
+		backwards += (times[i] < times[i-1]);
+		longest = std::max(longest, step);
 	}
 
+	clock.gaps += gaps;
+	clock.duplicates += duplicates;
+	clock.backwards += backwards;
+	clock.longeststep = std::max(clock.longeststep, longest);
+	clock.last = times[n-1];
+	clock.entries += n;
 }
 
 
 // ********************
-// a function to evaluate if the change in sensor temperatures is below the given limit -> are we in thermal equilibrium?
+// this function checks the time stamps of a run up to entry count, in blocks, reading only the time
 // ********************
 
-bool stablesystem(double mydelta)
+void scantimes(runstate& state, long int count)
 {
-	bool systemstablility = true;
-	for (int i=0;i<sensors;i++)
+	if (state.cachemap != 0)
 	{
-		deltaT[i] = temperature[i] - temperaturebefore[i];
-		temperaturebefore[i] = temperature[i];
-		// skip non-connected sensors //FIXME
-		if (i != 0 && i!= 9)
+		checktimes(state.clock, state.cachetime + state.clock.entries, count - state.clock.entries);
+		return;
+	}
+
+	// only the time branch is read, into a block of time stamps
+	TBranch* timebranch = state.mytuple->GetBranch("uTime");
+	unsigned int block[clockblock];
+	while (state.clock.entries < count)
+	{
+		long int first = state.clock.entries;
+		long int n = std::min((long int)clockblock, count - first);
+		for (long int i=0;i<n;i++)
 		{
-			if (!(fabs(deltaT[i]) <= mydelta))
+			int bytes = timebranch->GetEntry(first + i);
+			if (bytes > 0)
 			{
-				systemstablility = false;
-				if (debug<1)
-				{
-					cout << "System not in thermal equilibrium: deltaT [ " << i << " ] = " << deltaT[i] << endl;
-				}
+				state.bytesunzipped += bytes;
 			}
+			block[i] = state.uTime;
 		}
+		checktimes(state.clock, block, n);
 	}
-	return(systemstablility);
 }
 
 
 // ********************
-// a function to return the time
+// this function reports the gaps and repeated time stamps of a run
 // ********************
 
-double nicetime()
+void reportclock(runstate& state)
 {
-
-	// get the time of this event
-	TDatime thetime;
-	thetime = TDatime(uTime);
-
-	// problem with the time: e.g. 17:59:59 is when called as thetime.GetTime() 175.959
-	// the next time is 180000 as in 18:00:00 O'clock! Jump of 4000
-	// get the corrected, continuous time
-	if(usedpoints == 1)
+	const runclock& clock = state.clock;
+	if (debug<5 && (clock.gaps > 0 || clock.duplicates > 0 || clock.backwards > 0))
 	{
-		//this sets j to the next hour "thetime.GetTime()" will hit
-		time0 = thetime.GetTime();
-		temptime = (thetime.GetTime()-(thetime.GetTime() % 10000))/10000 + 1;
+		state.messages << "The daq time has " << clock.gaps << " gaps longer than " << daqgap << " s, the longest " << clock.longeststep << " s, ";
+		state.messages << clock.duplicates << " repeated and " << clock.backwards << " backward time stamps!" << endl;
+		state.messages << " " << endl;
 	}
-
-	if(temptime == 24 && thetime.GetTime() < 1000)
+	if (debug<3)
 	{
-		  // every full day we jump 240.000 minus the 4000 for a full hour!
-		  time0= time0 - 236000;
-		  temptime = 1;
-	}
-
-	if(thetime.GetTime() >= (temptime*10000))
-	{
-		  // every full hour we jump 4000 
-		  time0 = time0 +4000;
-		  temptime++;
+		state.messages << "The run takes " << clock.last - clock.first << " s for " << clock.entries << " entries!" << endl;
+		state.messages << " " << endl;
 	}
+}
 
-	double sometime = thetime.GetTime() - time0;
-	// now we have a continuous time!
 
-	return sometime;
+// ********************
+// a function to return the time of the current point in s since the start of the run
+// ********************
 
+double clocktime(runstate& state)
+{
+	return (double)state.uTime - (double)state.clock.first;
 }
 
 
 // ********************
-// a function to sort the sensors according to their position
+// a function to return the branches of the tuple the analysis reads
 // ********************
 
-void sensorsorting(int run)
+std::vector<std::string> usedbranches()
 {
-	float temptemperature[sensors] = {0.0};
-	for (int j=0;j<sensors;j++)
-	{
-		temptemperature[j] = temperature[j];
-	}
-	for (size_t i=0;i<sensorsort.at(run).size();i++)
+	std::vector<std::string> branches;
+	branches.push_back("uTime");
+	for (int row = 0; row < 10; ++row)
 	{
-		stringstream astream;
-		astream << sensorsort.at(run).at(i);
-		int temp = 0;
-		astream >> temp;
-		temperature[i] = temptemperature[temp];
-		if (debug<1)
-		{
-			cout << "Sorting sensors. Position " << i << " now has sensor " << sensorsort.at(run).at(i) << " with temperature " << temperature[i] << " C" << endl;
-		}
+		branches.push_back(Form("temperature%d", row));
 	}
+	branches.push_back("current1");
+	branches.push_back("workingTemperature");
+	return branches;
 }
 
 
 // ********************
-// a function to return the new position of a (broken) sorted sensor
+// this function trains the cache of a tuple on exactly the used branches, for all its entries, no learning phase needed
+// a followed tuple is trained again after each refresh, so the new entries are read through the cache as well
 // ********************
 
-int brokensorting(int run, int origsensor)
+long long traincache(runstate& state)
 {
-	int newsensor = -1;
-	for (size_t i=0;i<sensorsort.at(run).size();i++)
+
+	std::vector<std::string> branches = usedbranches();
+
+	// the cache only has to hold the used branches
+	long long cachesize = 0;
+	for (size_t k=0;k<branches.size();k++)
 	{
-		stringstream astream;
-		astream << sensorsort.at(run).at(i);
-		int temp = 0;
-		astream >> temp;
-		if (temp == origsensor)
+		TBranch* abranch = state.mytuple->GetBranch(branches.at(k).c_str());
+		if (abranch != 0)
 		{
-			newsensor = i;
+			cachesize += abranch->GetZipBytes();
 		}
 	}
-	return newsensor;
+	cachesize = std::min(cachesize + 1024*1024, (long long)maxcachesize);
+
+	state.mytuple->SetCacheSize(cachesize);
+	state.mytuple->SetCacheEntryRange(0, state.tupleentrycount);
+	for (size_t k=0;k<branches.size();k++)
+	{
+		state.mytuple->AddBranchToCache(branches.at(k).c_str());
+	}
+	state.mytuple->StopCacheLearningPhase();
+
+	return cachesize;
+
 }
 
 
 // ********************
-// the main function
+// this function returns the number of entries in a root file, used to schedule the largest runs first
 // ********************
 
-int main(int argc, char** argv)
+long int countentries(std::string myfile)
 {
+	long int entries = 0;
 
-	// user inputs which runlist to read
-	std::string astring = "fail";
-	stringstream astream;
-	if (argc>1)
+	// the cache knows it without root
+	runstate state;
+	if (cachedir != "" && opencache(myfile, state))
 	{
-		astream << argv[1];
-		astring = astream.str();
-	} else {
-		cout << "You did not specify a runlist! Please input a runlist now:" << endl;
-		getline (cin, astring);
+		entries = state.tupleentrycount;
+		munmap(state.cachemap, state.cachemapsize);
+		return entries;
 	}
 
-	// read the runlist into the vectors
-	readrunlist(astring);
+	TFile *f1 = TFile::Open(myfile.c_str());
+	if (f1 != 0 && !f1->IsZombie())
+	{
+		TTree* atuple = (TTree*)f1->Get("thermoDAQ");
+		if (atuple != 0)
+		{
+			entries = atuple->GetEntries();
+		}
+		f1->Close();
+	}
+	delete f1;
+	return entries;
+}
 
-	// then prepare the roots
-	prepareroot();
 
-	// loop over each measurement in the runlist
-	for (unsigned int ii=0;ii<filelist.size();ii++)
-	{
+// ********************
+// this function opens the individual root file
+// ********************
 
-		// open the file
-		openfile(filelist.at(ii));
+void openfile(int run, runstate& state)
+{
 
-		// let's go!
+	std::string myfile = filelist.at(run);
 
-		// prepare output
-		outputFile->cd();
-		char namechar[100];
-		sprintf(namechar, "Measurement %i", ii);
-		TDirectory* thisdirectory = outputFile->mkdir(namechar);
-		thisdirectory->cd();
+	// the stream - check if file exists
+	ifstream fileRead;
 
+	// open
+	fileRead.open(myfile.c_str());
 
-		// mode selection, 1 = calibration, 3 = calibration and analysis
-		if (mode == 1 || mode == 3)
-		{
+	if ( !fileRead.is_open() )
+	{
+		cout << "Error opening root file " << myfile << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
 
-			time1 = 0.0;
-			temptime = 0.0;
-			usedpoints = 0;
+	// close, let root do this
+	fileRead.close();
 
-			// draw
-			c_cali[ii]->cd();
-			h_cali[ii]->Draw("");
+	// rdataframe reads the tuple itself, with the time of the run
+	if (backend == 1)
+	{
+		state.tupleentrycount = countentries(myfile);
+		if (debug<5)
+		{
+			state.messages << " " << endl;
+			state.messages << "********************" << endl;
+			state.messages << "Looping "<< state.tupleentrycount << " entries in the input file " << myfile.c_str() << " with RDataFrame ..." << endl;
+			state.messages << "********************" << endl;
+			state.messages << " " << endl;
+		}
+		return;
+	}
 
-			if (debug<5)
+	// read from the column cache, written with the first use of a tuple
+	if (cachedir != "")
+	{
+		if (!opencache(myfile, state))
+		{
+			buildcache(myfile, state);
+			if (!opencache(myfile, state))
 			{
-				cout << " " << endl;
-				cout << "********************" << endl;
-				cout << "Running calibration!" << endl;
-				cout << "********************" << endl;
-				cout << " " << endl;
+				cout << "Error reading the column cache of " << myfile << " !" << endl;
+				exit ( EXIT_FAILURE );
 			}
+		}
 
-			// loop over all tuple entries
-			for(int i = 0; i < tupleentrycount;i++)
-			{
-				// only save every precision-th event
-				if (i % precision == 0)
-				{
-
-					// to make sure there is a gap in between the calibrations, count points between
-					inbetween++;
-		
-					// get the event
-					mytuple->GetEntry(i);
-
-					// count points for graphs
-					usedpoints++;
+		// each sorted position reads the column of its sensor
+		const float* columns[sensors];
+		for (int row = 0; row < sensors; ++row)
+		{
+			columns[row] = state.cachetemperature[sortorder.at(run).at(row)];
+		}
+		for (int row = 0; row < sensors; ++row)
+		{
+			state.cachetemperature[row] = columns[row];
+		}
 
-					// set the time
-					time1 = nicetime();
+		if (debug<5)
+		{
+			state.messages << " " << endl;
+			state.messages << "********************" << endl;
+			state.messages << "Looping "<< state.tupleentrycount << " entries in the column cache of " << myfile.c_str() << " ..." << endl;
+			state.messages << "********************" << endl;
+			state.messages << " " << endl;
+		}
 
-					// sort the sensors
-					sensorsorting(ii);
+		// the time of the whole run
+		scantimes(state, state.tupleentrycount);
+		reportclock(state);
+		return;
+	}
 
-					// now we analyse all calbration parts, there are 'calibs' of these.
-					if(calibs[ii] < maxcalibs)
-					{
+	// the file to open
+	state.inputfile = TFile::Open(myfile.c_str());
 
-						// there has to be a change of the bath temperature, then we start to look for a calibration point
-						if (workingTemperature != workingTemperaturebefore && inbetween > 50)
-						{
-							lookForCal = true;
-							if (debug<3)
-							{
-								cout << "Searching for calibration at time: " << time1 << endl;
-								cout << "Current working temperature is: " << workingTemperature << endl;
-								cout << "Measurement points since last search: " << inbetween << endl;
-								cout << " " << endl;
-							}
-							inbetween=0;
-						}
-
-						// make sure there is a gap between the calibrations
-						if(inbetween > 51)
-						{
-							workingTemperaturebefore = workingTemperature;
-						}
-
-						// the heater has to be off
-						if (lookForCal && current1 == 0)
-						{
-							insidecool = true;
-							if (debug<3)
-							{
-								cout << "Performing search!" << endl;
-								cout << "Measurement time is: " << time1 << endl;
-								cout << "Tuple point is: " << i << endl;
-								cout << " " << endl;
-							}
-
-							insidecool = stablesystem(deltacali);
-
-							// if alle sensors are good, then we add all temperatures to the calitemp
-							if (insidecool)
-							{
-								if (debug<3)
-								{
-									cout << "All deltaTs are good!" << endl;
-								}
-
-								for (int j = 0; j < sensors ; j++)
-								{
-									calitemp[ii][j][calibs[ii]] = calitemp[ii][j][calibs[ii]] + temperature[j];
-									if (debug<4)
-									{
-										cout << "Calibration point " << calitemp[ii][j][calibs[ii]] << " at working temperature " << workingTemperature << endl;
-									}
-									// shift the point for plotting
-									calibrationgraph[ii][calibs[ii]]->SetPoint(j, j-(calibs[ii]/2 + 1)*0.1*pointsep,  calitemp[ii][j][calibs[ii]]-workingTemperature);
-									calibrationgraph[ii][calibs[ii]]->SetPointError(j, 0,  (calitemp[ii][j][calibs[ii]]-workingTemperature)*errorpercentage);
-								}
-								calitime[ii][calibs[ii]] = time1;
-								work_Temperature[ii][calibs[ii]]= workingTemperature;
-								lookForCal = false;
-								if (debug<4)
-								{
-									cout << " " << endl;
-									cout << "Done " << calibs[ii] + 1 << " calibrations!" << endl;
-									cout << " " << endl;
-								}
-								calibs[ii]++;
-								pointsep = pointsep*(-1);
-							}
-						}
-					} // done calibs loop
-				} // done precision'th loop 
-			} // done tuple loop
-
-			// so now we can average the calitemps 
-			if (calibs[ii] > 0)
-			{
+	// enter the input file
+	state.inputfile->cd();
 
-				if (debug<4)
-				{
-					cout << "Averaging calibration points of " << calibs[ii] << " calibrations!" <<endl;
-				}
+	// go into the tree
+	state.mytuple = (TTree*)state.inputfile->Get("thermoDAQ");
 
-				float avg_cali_error[maxmeas][sensors] = {0.0};
-				for (int j = 0; j < sensors; j++)
-				{
-					// get the average
-					for (int k=0;k<calibs[ii];k++)
-					{
-						avg_calitemp[ii][j] += calitemp[ii][j][k]-work_Temperature[ii][k];
-					}
-					avg_calitemp[ii][j] /= calibs[ii];
-					avg_calibrationgraph[ii]->SetPoint(j, j, avg_calitemp[ii][j]);
+	// how many entries in this tuple?
+	state.tupleentrycount = state.mytuple->GetEntries();
+	if (debug<5)
+	{
+		state.messages << " " << endl;
+		state.messages << "********************" << endl;
+		state.messages << "Looping "<< state.tupleentrycount << " entries in the input file " << myfile.c_str() << " ..." << endl;
+		state.messages << "********************" << endl;
+		state.messages << " " << endl;
+	}
 
-					// get the standard deviation
-					for (int k=0;k<calibs[ii];k++)
-					{
-						avg_cali_error[ii][j] += (avg_calitemp[ii][j] - (calitemp[ii][j][k]-work_Temperature[ii][k]))*(avg_calitemp[ii][j] - (calitemp[ii][j][k]-work_Temperature[ii][k]));
-					}
-					avg_cali_error[ii][j] /= calibs[ii];
-					avg_cali_error[ii][j] = sqrt(avg_cali_error[ii][j]);
-					avg_calibrationgraph[ii]->SetPointError(j, 0, avg_cali_error[ii][j]);
-					if (debug<4)
-					{
-						cout << "Average calibration of sensor " << j << " is " << avg_calitemp[ii][j] << " +- " << avg_cali_error[ii][j] << " deg C." << endl;
-					}
-				}
-				if (debug<4)
-				{
-					cout << " " << endl;
-				}
+	// ********************
+	// connect branch and variable
+	// ********************
 
-			// if no calibrations were found, we have a bad measurement!
-			} else {
-				if (debug<5)
-				{
-					cout << "No possible calibration point found in run " << ii << "!" << endl;
-					cout << "Aborting run!" << endl;
-					cout << " " << endl;
-				}
-				continue;
-			}
-			
-			
-			// plot the output
-			for (int j=0;j<calibs[ii];j++)
-			{
-				c_cali[ii]->cd();
-				calibrationgraph[ii][j]->SetMarkerStyle(34);
-				calibrationgraph[ii][j]->SetMarkerColor(j+1);
-				calibrationgraph[ii][j]->SetMarkerSize(2);
-				calibrationgraph[ii][j]->SetLineColor(j+1);
-				calibrationgraph[ii][j]->SetLineWidth(2);
-				calibrationgraph[ii][j]->SetLineStyle(1);
-				calibrationgraph[ii][j]->Draw("P");
-				char tempchar[100];
-				sprintf(tempchar, "%.1f #circC", work_Temperature[ii][j]);
-				l_cali[ii]->AddEntry(calibrationgraph[ii][j],tempchar,"lp");
-				c_cali[ii]->Update();
-			}
-			c_cali[ii]->cd();
-			avg_calibrationgraph[ii]->SetMarkerStyle(34);
-			avg_calibrationgraph[ii]->SetMarkerColor(calibs[ii]+1);
-			avg_calibrationgraph[ii]->SetMarkerSize(2);
-			avg_calibrationgraph[ii]->SetLineColor(calibs[ii]+1);
-			avg_calibrationgraph[ii]->SetLineWidth(2);
-			avg_calibrationgraph[ii]->SetLineStyle(1);
-			avg_calibrationgraph[ii]->Draw("P");
-			l_cali[ii]->AddEntry(avg_calibrationgraph[ii],"Average","lp");
-			l_cali[ii]->Draw();
-			c_cali[ii]->Update();
-			c_cali[ii]->Write();
-			c_cali[ii]->Close();
-
-		} // done mode selection
+	// the time
+	state.mytuple->SetBranchAddress("uTime", &state.uTime);
 
-		// mode selection, 2 = analysis, 3 = calibration and analysis
-		if (mode == 2 || mode == 3)
+	// the temperatures of the sensors, each one goes directly to its sorted position
+	for (int row = 0; row < sensors; ++row)
+	{
+		state.mytuple->SetBranchAddress(Form("temperature%d", sortorder.at(run).at(row)), &state.temperature[row]);
+		if (debug<1)
 		{
+			state.messages << "Sorting sensors. Position " << row << " has sensor " << sortorder.at(run).at(row) << endl;
+		}
+	}
 
-			if (debug<5)
-			{
-				cout << " " << endl;
-				cout << "********************" << endl;
-				cout << "Running analysis!" << endl;
-				cout << "********************" << endl;
-				cout << " " << endl;
-			}
-
-			time1 = 0.0;
-			temptime = 0.0;
-			usedpoints = 0;
-
-			for (int j=0;j<sensors;j++)
-			{
-				temperaturebefore[j] = 0.0;
-			}
-			insidecool = false;
-			inbetween = 0;
+	// the current
+	state.mytuple->SetBranchAddress("current1", &state.current1);
 
-			// loop over all tuple entries
-			for(int i = 0; i < tupleentrycount;i++)
-			{
-				// only save every precision-th event
-				if (i % precision == 0)
-				{
-		
-					// get the event
-					mytuple->GetEntry(i);
+	// the working temperature
+	state.mytuple->SetBranchAddress("workingTemperature", &state.workingTemperature);
 
-					// count points for graphs
-					usedpoints++;
+	// only decode what we use, read through a cache
+	if (iomode == 1)
+	{
+		std::vector<std::string> branches = usedbranches();
 
-					// set the time
-					time1 = nicetime();
+		// switch off everything else the daq writes
+		state.mytuple->SetBranchStatus("*", 0);
+		for (size_t k=0;k<branches.size();k++)
+		{
+			state.mytuple->SetBranchStatus(branches.at(k).c_str(), 1);
+		}
 
-					// sort the sensors
-					sensorsorting(ii);
+		long long cachesize = traincache(state);
+		if (debug<3)
+		{
+			state.messages << "Reading " << branches.size() << " branches through a cache of " << cachesize << " bytes!" << endl;
+			state.messages << " " << endl;
+		}
+	}
 
-					// apply calibration
-					// use average if no calibration for a working point is found
-					bool applyaverage = true;
+	state.bytesread = state.inputfile->GetBytesRead();
+	state.bytesunzipped = 0;
 
-					// if there is a calibration for this specific working temperature, apply it
-					for (int j = 0;j<maxcalibs;j++)
-					{
-						// if the working temperature is within 5% of the one used for calibration
-						if ((work_Temperature[ii][j] >= (workingTemperature-workingTemperature*0.05)) && (work_Temperature[ii][j] <= (workingTemperature+workingTemperature*0.05)))
-						{
-							temperature[0] = temperature[0] - calitemp[ii][0][j] + work_Temperature[ii][j];
-							temperature[1] = temperature[1] - calitemp[ii][1][j] + work_Temperature[ii][j];
-							temperature[2] = temperature[2] - calitemp[ii][2][j] + work_Temperature[ii][j];
-							temperature[3] = temperature[3] - calitemp[ii][3][j] + work_Temperature[ii][j];
-							temperature[4] = temperature[4] - calitemp[ii][4][j] + work_Temperature[ii][j];
-
-							temperature[5] = temperature[5] - calitemp[ii][5][j] + work_Temperature[ii][j];
-							temperature[6] = temperature[6] - calitemp[ii][6][j] + work_Temperature[ii][j];
-							temperature[7] = temperature[7] - calitemp[ii][7][j] + work_Temperature[ii][j];
-							temperature[8] = temperature[8] - calitemp[ii][8][j] + work_Temperature[ii][j];
-							temperature[9] = temperature[9] - calitemp[ii][9][j] + work_Temperature[ii][j];
-
-							if (debug<1)
-							{
-								cout << "Found correct calibration at point " << j << " with " << work_Temperature[ii][j] << " deg C!" << endl;
-							}
-
-							applyaverage = false;
-							break;
-						}
-					}
+	// the time of the whole run
+	scantimes(state, state.tupleentrycount);
+	reportclock(state);
 
-					if (applyaverage)
-					{
-						temperature[0] = temperature[0] - avg_calitemp[ii][0];
-						temperature[1] = temperature[1] - avg_calitemp[ii][1];
-						temperature[2] = temperature[2] - avg_calitemp[ii][2];
-						temperature[3] = temperature[3] - avg_calitemp[ii][3];
-						temperature[4] = temperature[4] - avg_calitemp[ii][4];
-
-						temperature[5] = temperature[5] - avg_calitemp[ii][5];
-						temperature[6] = temperature[6] - avg_calitemp[ii][6];
-						temperature[7] = temperature[7] - avg_calitemp[ii][7];
-						temperature[8] = temperature[8] - avg_calitemp[ii][8];
-						temperature[9] = temperature[9] - avg_calitemp[ii][9];
-
-						if (debug<1)
-						{
-							cout << "Did not find correct calibration, applying average!" << endl;
-						}
-					}
+}
 
-					// the temperature difference between different sensors
-					for (int j = 0;j<sensors;j++)
-					{
-						if (j > 0)
-						{
-							deltaDT[j] = temperature[j] - temperature[j-1];
-						} else {
-							deltaDT[j] = temperature[j] - temperature[9];
-						}
-					}
 
-					// print some output
-					if (debug<0)
-					{
-						cout << "Data point: " << i << " , temperatures: " << temperature[0] << " " << temperature[1] << " " << temperature[2] << " " << temperature[3] << " " << temperature[4] << " " << temperature[5] << " " << temperature[6] << " " << temperature[7] << " " << temperature[8] << " " << temperature[9] <<" at time: " << time1 <<  endl;
-						cout << "DeltaDT is: " << deltaDT[0] << " " << deltaDT[1] << " " << deltaDT[2] << " " << deltaDT[3] << " " << deltaDT[4] << " " << deltaDT[5] << " " << deltaDT[6] << " " << deltaDT[7] << " " << deltaDT[8] << " " << deltaDT[9] << endl;
-					}
+// ********************
+// this function reads an entry of the tuple of a run and counts the decompressed bytes
+// ********************
 
-					// fill the time graphs
-					for (int j=0;j<sensors;j++)
-					{
-						tempgraph[ii][j]->SetPoint(usedpoints, time1, temperature[j]);
-						deltatempgraph[ii][j]->SetPoint(usedpoints, time1, deltaDT[j]);
-					}
+void readentry(runstate& state, long int i)
+{
+	if (state.cachemap != 0)
+	{
+		state.uTime = state.cachetime[i];
+		for (int row = 0; row < sensors; ++row)
+		{
+			state.temperature[row] = state.cachetemperature[row][i];
+		}
+		state.current1 = state.cachecurrent[i];
+		state.workingTemperature = state.cacheworking[i];
+		return;
+	}
+	int bytes = state.mytuple->GetEntry(i);
+	if (bytes > 0)
+	{
+		state.bytesunzipped += bytes;
+	}
+}
 
-					// are we in thermal equilibrium?
-					insidecool = stablesystem(deltagrad);
-					if (insidecool)
-					{
-						inbetween++;
-					}
 
-					// require >2 stable points between actual points, also current on
-					if (insidecool && (inbetween > 2) && current1 > 0.0)
-					{
-						for (int j = 0; j < sensors ; j++)
-						{
-							stabletemp[ii][j][stablepoints[ii]] = temperature[j];
-							
-						}
-						if (debug<3)
-						{
-							cout << "Found stable point no. " << stablepoints[ii] << " at " << time1 << " s!" << endl;
-						}
-
-						// save working temperature, current and time
-						stablework[ii][stablepoints[ii]] = workingTemperature;
-						stablecurrent[ii][stablepoints[ii]] = current1;
-						stabletime[ii][stablepoints[ii]] = time1;
-
-						// increase the count
-						stablepoints[ii]++;
-
-						// reset the distance counter
-						inbetween = 0;
-					}
+// ********************
+// this function closes the root file of a run again
+// ********************
 
-				} // done precision'th loop 
-			} // done tuple loop
+void closefile(runstate& state)
+{
+	if (state.cachemap != 0)
+	{
+		if (debug<4)
+		{
+			state.messages << "Mapped " << state.cachemapsize << " bytes of the column cache!" << endl;
+			state.messages << " " << endl;
+		}
+		munmap(state.cachemap, state.cachemapsize);
+		state.cachemap = 0;
+	}
+	if (state.inputfile != 0)
+	{
+		state.bytesread = state.inputfile->GetBytesRead() - state.bytesread;
+		if (debug<4)
+		{
+			state.messages << "Read " << state.bytesread << " bytes from the input file, decompressed " << state.bytesunzipped << " bytes!" << endl;
+			state.messages << " " << endl;
+		}
+		state.inputfile->Close();
+		delete state.inputfile;
+	}
+	state.inputfile = 0;
+	state.mytuple = 0;
+}
 
-			if (debug<4)
-			{
-				cout << "Done tuple loop, plotting output!" << endl;
-				cout << "Found " << stablepoints[ii] << " gradient points!" << endl;
-				cout << " " << endl;
-			}
 
-			// plot the output
-			int tempcounter = 0;
+// ********************
+// a function to compile the sensor sorting of a runlist line into the sensor read at each position
+// ********************
 
-			// the temperatures
-			c_temps[ii]->cd();
-			h_temps[ii]->Draw("");
-			for (int j=0;j<sensors;j++)
-			{
+std::vector<int> compilesorting(std::string sorting, int linenumber)
+{
+	std::vector<int> order;
+	unsigned int seen = 0;
+	if ((int)sorting.size() != sensors)
+	{
+		cout << "Error in runlist line " << linenumber << ": sensor sorting " << sorting << " must have " << sensors << " sensors!" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	for (int i=0;i<sensors;i++)
+	{
+		int sensor = sorting.at(i) - '0';
+		if (sensor < 0 || sensor >= sensors || (seen & (1u << sensor)))
+		{
+			cout << "Error in runlist line " << linenumber << ": sensor sorting " << sorting << " is not a sorting of the sensors 0 to " << sensors-1 << "!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		seen |= (1u << sensor);
+		order.push_back(sensor);
+	}
+	return order;
+}
 
-				// skip 0 //FIXME
-				if (j != 0)
-				{
-					c_temps[ii]->cd();
-					tempgraph[ii][j]->SetMarkerStyle(34);
-					tempgraph[ii][j]->SetMarkerColor(tempcounter+1);
-					tempgraph[ii][j]->SetMarkerSize(2);
-					tempgraph[ii][j]->SetLineColor(tempcounter+1);
-					tempgraph[ii][j]->SetLineWidth(2);
-					tempgraph[ii][j]->SetLineStyle(1);
-					tempgraph[ii][j]->Draw("L");
-					char tempchar[100];
-					sprintf(tempchar, "Sensor %i", j);
-					l_temps[ii]->AddEntry(tempgraph[ii][j],tempchar,"lp");
-					c_temps[ii]->Update();
-					tempcounter++;
-				}
-			}
-			tempcounter = 0;
 
-			// draw the lines of the calibration times
-			for (int j=0;j<calibs[ii];j++)
-			{
-				c_temps[ii]->cd();
-				caliposition[ii][j]->SetLineWidth(1);
-				caliposition[ii][j]->SetLineColor(2);
-				caliposition[ii][j]->SetLineStyle(6);
-				caliposition[ii][j]->SetX1(calitime[ii][j]);
-				caliposition[ii][j]->SetX2(calitime[ii][j]);
-				caliposition[ii][j]->SetY1(-10);
-				caliposition[ii][j]->SetY2(50);
-				caliposition[ii][j]->Draw();
-			}
+// ********************
+// a function to compile the broken sensors of a runlist line into a mask of sorted positions
+// ********************
 
-			// draw the lines of the gradient times
-			for (int j=0;j<stablepoints[ii];j++)
+unsigned int compilebroken(std::string broken, const std::vector<int>& order, int linenumber)
+{
+	unsigned int mask = 0;
+	for (size_t i=0;i<broken.size();i++)
+	{
+		// allow separators between the sensors
+		if (broken.at(i) == ' ' || broken.at(i) == ';' || broken.at(i) == '-')
+		{
+			continue;
+		}
+		int sensor = broken.at(i) - '0';
+		if (sensor < 0 || sensor >= sensors)
+		{
+			cout << "Error in runlist line " << linenumber << ": broken sensor " << broken.at(i) << " is not a sensor!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		for (int k=0;k<sensors;k++)
+		{
+			if (order.at(k) == sensor)
 			{
-				c_temps[ii]->cd();
-				gradposition[ii][j]->SetLineWidth(1);
-				gradposition[ii][j]->SetLineColor(1);
-				gradposition[ii][j]->SetLineStyle(5);
-				gradposition[ii][j]->SetX1(stabletime[ii][j]);
-				gradposition[ii][j]->SetX2(stabletime[ii][j]);
-				gradposition[ii][j]->SetY1(-10);
-				gradposition[ii][j]->SetY2(50);
-				gradposition[ii][j]->Draw();
+				mask |= (1u << k);
 			}
+		}
+	}
+	return mask;
+}
 
-			c_temps[ii]->cd();
-			l_temps[ii]->Draw();
-			c_temps[ii]->Update();
-			c_temps[ii]->Write();
-			c_temps[ii]->Close();
 
-			// the delta temperatures
-			c_deltatemps[ii]->cd();
-			h_deltatemps[ii]->Draw("");
-			for (int j=0;j<sensors;j++)
-			{
-				// skip 0 and 4
-				// also 1 and 5
-				if (j != 0 && j != 4 && j != 1 && j != 5)
-				{
-					c_deltatemps[ii]->cd();
-					deltatempgraph[ii][j]->SetMarkerStyle(34);
-					deltatempgraph[ii][j]->SetMarkerColor(tempcounter+1);
-					deltatempgraph[ii][j]->SetMarkerSize(2);
-					deltatempgraph[ii][j]->SetLineColor(tempcounter+1);
-					deltatempgraph[ii][j]->SetLineWidth(2);
-					deltatempgraph[ii][j]->SetLineStyle(1);
-					deltatempgraph[ii][j]->Draw("L");
-					char tempchar[100];
-					sprintf(tempchar, "Sensor %i - Sensor %i", j, j-1);
-					l_deltatemps[ii]->AddEntry(deltatempgraph[ii][j],tempchar,"lp");
-					c_deltatemps[ii]->Update();
-					tempcounter++;
-				}
-			}
-			tempcounter = 0;
+// ********************
+// a field of a runlist line, pointing into the text of the runlist, so the line is split without copying it
+// ********************
 
-			// draw the lines of the gradient times
-			for (int j=0;j<stablepoints[ii];j++)
-			{
-				c_deltatemps[ii]->cd();
-				gradposition[ii][j]->SetLineWidth(1);
-				gradposition[ii][j]->SetLineColor(1);
-				gradposition[ii][j]->SetLineStyle(5);
-				gradposition[ii][j]->SetX1(stabletime[ii][j]);
-				gradposition[ii][j]->SetX2(stabletime[ii][j]);
-				gradposition[ii][j]->SetY1(-10);
-				gradposition[ii][j]->SetY2(10);
-				gradposition[ii][j]->Draw();
-			}
+struct fieldview
+{
+	const char* start;
+	size_t length;
 
-			c_deltatemps[ii]->cd();
-			l_deltatemps[ii]->Draw();
-			c_deltatemps[ii]->Update();
-			c_deltatemps[ii]->Write();
-			c_deltatemps[ii]->Close();
+	std::string str() const
+	{
+		return std::string(start, length);
+	}
+};
 
-			// the temperature gradients
-			c_gradtemps[ii]->cd();
-			h_gradtemps[ii]->Draw();
-			const int n = 8;
-			for (int j=0;j<stablepoints[ii];j++)
-			{
-				Double_t x[n] = {72,64,56,48,32,24,16,8};
-				Double_t y[n] = {stabletemp[ii][1][j],stabletemp[ii][2][j],stabletemp[ii][3][j],stabletemp[ii][4][j],stabletemp[ii][5][j],stabletemp[ii][6][j],stabletemp[ii][7][j],stabletemp[ii][8][j]};
-				for (int k=0;k<8;k++)
-				{
 
-					if (debug<2)
-					{
-						cout << "Adding point " << k << " of stable point " << j << " at " << x[k] << " mm, " << y[k] << " K!" << endl;
-					}
-					gradgraph[ii][j]->SetPoint(k,x[k]-((j/2 + 1)*0.5*pointsep),y[k]);
-					gradgraph[ii][j]->SetPointError(k,1,y[k]*errorpercentage);
+// ********************
+// a function to tell if a field of the runlist is a whole number
+// ********************
 
-				}
-				pointsep = pointsep * (-1);
-				c_gradtemps[ii]->cd();
-				gradgraph[ii][j]->SetMarkerStyle(34);
-				gradgraph[ii][j]->SetMarkerColor(j+1);
-				gradgraph[ii][j]->SetMarkerSize(2);
-				gradgraph[ii][j]->SetLineColor(j+1);
-				gradgraph[ii][j]->SetLineWidth(2);
-				gradgraph[ii][j]->SetLineStyle(1);
-				gradgraph[ii][j]->Draw("P");
-				char tempchar[100];
-				sprintf(tempchar, "Measurement point %i", j);
-				l_gradtemps[ii]->AddEntry(gradgraph[ii][j],tempchar,"lp");
-				c_gradtemps[ii]->Update();
-				
-				// check if there is a bad sensor and remove it from the gradient plot:
-				for (int k=0;k<sensors;k++)
-				{
-					std::ostringstream ss;
-					ss << k;
-					
-					std::size_t found = brokenlist.at(ii).find(ss.str());
-					if (found!=std::string::npos)
-					{
-						if (debug<3)
-						{
-							cout << "Found broken sensor " << k << " removing point " << brokensorting(ii,k) << endl;
-						}
-						gradgraph[ii][j]->RemovePoint(brokensorting(ii,k)-1);
-					}
-				}
+bool isnumber(const fieldview& field)
+{
+	if (field.length == 0 || field.length > 9)
+	{
+		return false;
+	}
+	for (size_t i=0;i<field.length;i++)
+	{
+		if (field.start[i] < '0' || field.start[i] > '9')
+		{
+			return false;
+		}
+	}
+	return true;
+}
 
-				// fit
-				sprintf(tempchar, "fitlow%i%i", ii, j);
-				gradgraph[ii][j]->Fit(tempchar, "RQ");
-				gradfit1[ii][j]->Draw("l same");
-				sprintf(tempchar, "fithigh%i%i", ii, j);
-				gradgraph[ii][j]->Fit(tempchar, "RQ");
-				gradfit2[ii][j]->Draw("l same");
 
-				// calculate the temperature difference from the fit difference
-				float lowtemp = gradfit1[ii][j]->Eval(40.0) + greasetemp/2.0;
-				float hightemp = gradfit2[ii][j]->Eval(40.0) - greasetemp/2.0;
-				tempdiff[ii][j] = hightemp - lowtemp;
+// ********************
+// read the runlist - this opens the runlist and gets the tuple names and other infos for plotting
+// each line is: file,sensor sorting,broken sensors,thickness,material,comment - the comment is the rest of the line
+// ********************
 
-				// define the measurement temperature of this as the average between top and bottom blocks
-				tempdifftemp[ii][j] = (hightemp + lowtemp)/2.0;
-				avg_tempdiff += tempdiff[ii][j];
-				h_blockdifference[ii]->Fill(tempdiff[ii][j]);
+void readrunlist(std::string astring)
+{
+	// the stream
+	ifstream fileRead;
 
-				if (debug<4)
-				{
-					cout << "Point " << j << ":" << endl;
-					cout << "Temperature difference between blocks is " << tempdiff[ii][j] << " K." << endl;
-				}
+	// open
+	fileRead.open(astring.c_str(), std::ios::binary);
 
-				// the gradient between the aluminium blocks
-				gradient_blocks += gradfit1[ii][j]->GetParameter(1);
-				gradient_blocks += gradfit2[ii][j]->GetParameter(1);
+	if ( !fileRead.is_open() )
+	{
+		cout << "Error opening runlist file " << astring << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
 
-				// calculate lambda of the blocks
-				float lambda_al = resistor * stablecurrent[ii][j] * stablecurrent[ii][j] / (( (gradfit1[ii][j]->GetParameter(1) + gradfit2[ii][j]->GetParameter(1)) / 2.0*1000.0) * area );
-				if (debug<4)
-				{
-					cout << "Alu Lambda is " << lambda_al << " W/(mK) at T = " << stablework[ii][j] << " °C." <<  endl;
-				}
-				
-				if (debug<4)
-				{
-					cout << "Thermal resistance is " << tempdiff[ii][j]/(resistor * stablecurrent[ii][j] * stablecurrent[ii][j]) << " K/W." <<  endl;
-					cout << " " << endl;
-				}
+	// the whole runlist at once, the lines and fields only point into it
+	// read as a stream, so a pipe works as well as a file
+	std::string text((std::istreambuf_iterator<char>(fileRead)), std::istreambuf_iterator<char>());
+	fileRead.close();
+
+	if (debug<5)
+	{
+		cout << " " << endl;
+		cout << "********************" << endl;
+		cout << "Reading runlist!" << endl;
+		cout << "********************" << endl;
+		cout << " " << endl;
+	}
+
+	int filecounter = 0;
 
+	// the line in the file, for error messages
+	int linenumber = 0;
+
+	// the materials, thicknesses and files seen so far, to find each in constant time
+	std::unordered_map<std::string, int> materialindex;
+	std::unordered_map<int, int> thicknessindex;
+	std::unordered_map<std::string, int> fileline;
+	for (int i=0;i<materialcount;i++)
+	{
+		materialindex[materiallist.at(i)] = i;
+	}
+	for (int i=0;i<thicknesscount;i++)
+	{
+		thicknessindex[thicknesslist.at(i)] = i;
+	}
+
+	// the fields of a line: file, sorting, broken sensors, thickness, material and comment
+	const int nfields = 6;
+	fieldview field[nfields];
+
+	// loop over the lines in the file
+	const char* end = text.data() + text.size();
+	for (const char* line = text.data(); line < end; )
+	{
+
+		linenumber++;
+
+		// the end of this line, without a windows line end
+		const char* lineend = (const char*)memchr(line, '\n', end - line);
+		if (lineend == 0)
+		{
+			lineend = end;
+		}
+		const char* next = lineend + 1;
+		if (lineend > line && lineend[-1] == '\r')
+		{
+			lineend--;
+		}
+
+		// comment lines start with #, empty lines are skipped
+		bool empty = true;
+		for (const char* c = line; c < lineend; c++)
+		{
+			if (*c != ' ' && *c != '\t')
+			{
+				empty = false;
+				break;
 			}
-			c_gradtemps[ii]->cd();
-			l_gradtemps[ii]->Draw();
-			c_gradtemps[ii]->Update();
+		}
+		if (*line == '#' || empty)
+		{
+			line = next;
+			continue;
+		}
 
-			// calculate average temperature difference
-			if (stablepoints[ii] > 0)
+		// split the line at the commas, in one pass
+		int nfound = 0;
+		const char* start = line;
+		for (const char* c = line; c <= lineend && nfound < nfields; c++)
+		{
+			if (c == lineend || (*c == ',' && nfound < nfields-1))
 			{
-				avg_tempdiff /= stablepoints[ii];
-				if (debug<4)
-				{
-					cout << " " << endl;
-					cout << "Average temperature difference between blocks is " << avg_tempdiff << " K!" << endl;
-				}
+				field[nfound].start = start;
+				field[nfound].length = c - start;
+				nfound++;
+				start = c + 1;
+			}
+		}
+		if (nfound < nfields-1)
+		{
+			cout << "Error in runlist line " << linenumber << ": found " << nfound << " fields instead of file,sorting,broken,thickness,material[,comment]!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		if (nfound < nfields)
+		{
+			field[nfields-1].start = lineend;
+			field[nfields-1].length = 0;
+		}
 
-				// the average gradient in aluminium, 2* since there are 2 fits...
-				gradient_blocks /= (2*stablepoints[ii]);
-				if (debug<4)
-				{
-					cout << "Average temperature gradient between blocks is " << gradient_blocks*1000.0 << " K/m." << endl;
-					cout << " " << endl;
-				}
-			} else {
-				if (debug<5)
-				{
-					cout << "No stable gradient points found!" << endl;
-					cout << " " << endl;
-				}
+		// first the filename
+		std::string fail = field[0].str();
+		if (fail.empty())
+		{
+			cout << "Error in runlist line " << linenumber << ": the file name is empty!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		std::unordered_map<std::string, int>::iterator seen = fileline.find(fail);
+		if (seen != fileline.end())
+		{
+			if (debug<5)
+			{
+				cout << "Warning: runlist line " << linenumber << " repeats the file of line " << seen->second << " !" << endl;
 			}
+		} else {
+			fileline[fail] = linenumber;
+		}
 
-			c_gradtemps[ii]->Write();
-			c_gradtemps[ii]->Close();
-			h_blockdifference[ii]->Write();
+		// push the name into the vector
+		filelist.push_back(fail);
 
-		} // done mode selection
+		if (debug<4)
+		{
+			cout << "Found file no: " << filecounter << " : " << fail << " !" << endl;
+		}
+
+		// nameing starts at 0
+		filecounter++;
+
+		// the sensor sorting
+		sensorsort.push_back(field[1].str());
 
-		if (mode == 0)
+		if (debug<4)
 		{
-		  
-			if (debug<5)
+			cout << "Found sensor sorting: " << sensorsort.back() << " !" << endl;
+		}
+
+		// the broken sensors
+		brokenlist.push_back(field[2].str());
+
+		// compile sorting and broken sensors, so the analysis does not have to parse them again
+		sortorder.push_back(compilesorting(sensorsort.back(), linenumber));
+		brokenmask.push_back(compilebroken(brokenlist.back(), sortorder.back(), linenumber));
+
+		if (debug<4)
+		{
+			cout << "Found broken sensor: " << brokenlist.back() << " !" << endl;
+		}
+
+		// the material thickness
+		if (!isnumber(field[3]))
+		{
+			cout << "Error in runlist line " << linenumber << ": thickness " << field[3].str() << " is not a whole number!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		int athickness = atoi(field[3].str().c_str());
+
+		// push the thickness into the vector
+		thickness.push_back(athickness);
+
+		if (debug<4)
+		{
+			cout << "Found thickness: " << athickness << " !" << endl;
+		}
+
+		// sort thicknesses
+		thicknessid.push_back(thicknessindex.count(athickness) ? thicknessindex[athickness] : thicknesscount);
+		if (thicknessindex.count(athickness))
+		{
+			if (debug <1)
 			{
-				cout << " " << endl;
-				cout << "********************" << endl;
-				cout << "Running testing!" << endl;
-				cout << "********************" << endl;
-				cout << " " << endl;
+				cout << "Thickness " << athickness << " already in list!" << endl;
 			}
+		} else {
+			thicknessindex[athickness] = thicknesscount;
+			thicknesscount++;
+			thicknesslist.push_back(athickness);
+			if (debug <2)
+			{
+				cout << "Thickness " << athickness << " not in list! Total thicknesses now " << thicknesscount << endl;
+			}
+		}
+
+		// the material type
+		fail = field[4].str();
+		if (fail.empty())
+		{
+			cout << "Error in runlist line " << linenumber << ": the material is empty!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+
+		// push the name into the vector
+		material.push_back(fail);
+
+		if (debug<4)
+		{
+			cout << "Found material: " << fail << " !" << endl;
+		}
 
-			// loop over all tuple entries
-			for(int ij = 0; ij < tupleentrycount;ij++)
+		// sort materials
+		materialid.push_back(materialindex.count(fail) ? materialindex[fail] : materialcount);
+		if (materialindex.count(fail))
+		{
+			if (debug <1)
 			{
-				// only save every precision-th event
-				if (ij % precision == 0)
-				{
-		
-					// count points for graphs
-					usedpoints++;
-		
-					//make sure, there is a gap in between the calibrations
-					inbetween++;
-		
-					// get the event
-					mytuple->GetEntry(ij);
-		
-					
-				} // done precision'th loop 
-			} // done tuple loop
-		} // done mode selection
-
-		// catch wrong mode entry
-		if ( mode < 0 || mode > 3)
-		{
-			cout << "Wrong value for mode! Allowed settings are:" << endl;
-			cout << " 0 - Testing" << endl;
-			cout << " 1 - Calibration" << endl;
-			cout << " 2 - Analysis" << endl;
-			cout << " 3 - Calibration and analysis" << endl;
-			continue;
+				cout << "Material " << fail << " already in list!" << endl;
+			}
+		} else {
+			materialindex[fail] = materialcount;
+			materialcount++;
+			materiallist.push_back(fail);
+			if (debug <2)
+			{
+				cout << "Material " << fail << " not in list! Total materials now " << materialcount << endl;
+			}
 		}
 
-		// we're done with a file, so some cleaning up
-		time1 = 0.0;
-		temptime = 0.0;
-		usedpoints = 0;
+		// comments
+		comments.push_back(field[5].str());
 
-	} // done measurement loop
+		if (debug<4)
+		{
+			cout << "Found comment: " << comments.back() << " !" << endl;
+			cout << " " << endl;
+		}
 
-	// now time to do some comparisons between measurement runs
+		line = next;
 
-	if (debug<5)
-	{
-		cout << " " << endl;
-		cout << "********************" << endl;
-		cout << "Preparing final analysis!" << endl;
-		cout << "********************" << endl;
-		cout << " " << endl;
-	}
+	} // done while reading
 
-	// point counter for this graph
-	int g_blockcompmaterialcount[maxmeas] = {0};
-	int g_gradcompmaterialcount[maxmeas] = {0};
+}
 
-	// prepare output canvas
-	outputFile->cd();
-	c_blockcompmaterial_g->cd();
-	h_blockcompmaterial_g->Draw();
 
-	c_blockcompmaterial_g2->cd();
-	h_blockcompmaterial_g2->Draw();
+// ********************
+// a function to add a point to the stability detector and drop the points that left its window
+// ********************
 
+void pushwindow(stabilitywindow& w, double time, const float* temperature)
+{
 
-	c_gradcompmaterial->cd();
-	h_gradcompmaterial->Draw();
+	size_t capacity = w.time.size();
 
-	// loop the materials
-	for (int l=0;l<materialcount;l++)
+	// drop the points that left the window
+	while (w.count > 0 && w.time[w.first] < time - stablewindow)
 	{
-
-		if (debug<1)
+		double t = w.time[w.first] - w.time0;
+		w.st -= t;
+		w.stt -= t*t;
+		for (int i=0;i<sensors;i++)
 		{
-			cout << "Looping all materials: " << materiallist.at(l) << endl;
+			double y = w.temperature[i][w.first] - w.temperature0[i];
+			w.sy[i] -= y;
+			w.syy[i] -= y*y;
+			w.sty[i] -= t*y;
 		}
+		w.first = (w.first + 1) % capacity;
+		w.count--;
+	}
 
-		// loop thicknesses
-		for (int m=0;m<thicknesscount;m++)
+	// an empty window starts the sums again from this point
+	if (w.count == 0)
+	{
+		w.first = 0;
+		w.time0 = time;
+		w.st = 0.0;
+		w.stt = 0.0;
+		for (int i=0;i<sensors;i++)
 		{
+			w.temperature0[i] = temperature[i];
+			w.sy[i] = 0.0;
+			w.syy[i] = 0.0;
+			w.sty[i] = 0.0;
+		}
+	}
 
-			if (debug<1)
+	// a full ring buffer doubles its size, the oldest point goes first
+	if (w.count == capacity)
+	{
+		size_t newcapacity = capacity > 0 ? 2*capacity : 64;
+		std::vector<double> newtime(newcapacity);
+		for (size_t k=0;k<w.count;k++)
+		{
+			newtime[k] = w.time[(w.first + k) % capacity];
+		}
+		w.time.swap(newtime);
+		for (int i=0;i<sensors;i++)
+		{
+			std::vector<float> newtemperature(newcapacity);
+			for (size_t k=0;k<w.count;k++)
 			{
-				cout << "Looping all thicknesses: " << thicknesslist.at(m) << endl;
+				newtemperature[k] = w.temperature[i][(w.first + k) % capacity];
 			}
+			w.temperature[i].swap(newtemperature);
+		}
+		w.first = 0;
+		capacity = newcapacity;
+	}
 
-			// go through all measurements and look for the different parameters - "sorting"
-			for (unsigned int ik=0;ik<filelist.size();ik++)
-			{
+	// add the new point
+	size_t last = (w.first + w.count) % capacity;
+	double t = time - w.time0;
+	w.time[last] = time;
+	w.st += t;
+	w.stt += t*t;
+	for (int i=0;i<sensors;i++)
+	{
+		double y = temperature[i] - w.temperature0[i];
+		w.temperature[i][last] = temperature[i];
+		w.sy[i] += y;
+		w.syy[i] += y*y;
+		w.sty[i] += t*y;
+	}
+	w.count++;
 
-				if (material.at(ik) == materiallist.at(l))
-				{
-					if (thickness.at(ik) == thicknesslist.at(m))
-					{
-						if (debug<4)
-						{
-							cout << "Looping all calibrations!" << endl;
-							cout << " " << endl;
-						}
-
-						// go over the calibrations
-						for (int j=0;j<calibs[ik];j++)
-						{
-							for (int k=0;k<sensors;k++)
-							{
-								h_calicomp[k]->Fill(work_Temperature[ik][j], calitemp[ik][k][j]-work_Temperature[ik][j]);
-								// some more comparison?
-								if (debug<2)
-								{
-									cout << "Run: " << ik << ", calibration: " << j << " , sensor: " << k << " , calibration temperature: " << calitemp[ik][k][j] << " , working temperature: "<< work_Temperature[ik][j] << endl;
-								}
-							}
-						}
-
-						if (debug<2)
-						{
-							cout << " " << endl;
-						}
-
-						// go over the stable points
-						for (int j=0;j<stablepoints[ik];j++)
-						{
-							// fill histograms
-							// the temperature difference
-							h_blockcompmaterial[l]->Fill( tempdiff[ik][j]);
-
-							// the temperature difference at the measurement temp
-							h_blockcompmaterial_2D[l]->Fill(tempdifftemp[ik][j] , tempdiff[ik][j]);
-
-							// add the points to the graph of this material
-							g_blockcompmaterial[l]->SetPoint(g_blockcompmaterialcount[l],tempdifftemp[ik][j],tempdiff[ik][j]);
-
-							// vs slope
-
-							// maxmeas maxstable
-							float slope1 = gradfit1[ik][j]->GetParameter(1);
-							float slope2 = gradfit2[ik][j]->GetParameter(1);
-							g_blockcompmaterial2[l]->SetPoint(g_blockcompmaterialcount[l],((slope1 + slope2)/2.0),tempdiff[ik][j]);
-							g_blockcompmaterialcount[l]++;
-
-							float lambda = resistor * stablecurrent[ik][j] * stablecurrent[ik][j] / area / ((slope1 + slope2)/2.0*1000.0);
-
-							if (debug<2)
-							{
-								cout << "Run: " << ik << ", stable point: " << j << ", lambda: " << lambda << endl;
-							}
-
-							g_gradcompmaterial[l]->SetPoint(g_gradcompmaterialcount[l],tempdifftemp[ik][j],lambda);
-							
-							g_gradcompmaterialcount[l]++;
-
-							if (debug<1)
-							{
-								cout << "Filling comparison output histos: Run " << ik << ", stable point " << j << endl;
-							}
-						}
-
-						if (debug<2)
-						{
-							cout << " " << endl;
-						}
-
-					} // done if thickness
-				} // done if material
-
-			} // done filelist loop int i
-		
-		} // done thickness loop int m
+}
 
-		// the comparisons between materials
-		outputFile->cd();
-		char tempchar[100];
-		sprintf(tempchar, "Comparison of Material %s", materiallist.at(l).c_str());
-		TDirectory* materialdirectory = outputFile->mkdir(tempchar);
-		materialdirectory->cd();
-		h_blockcompmaterial[l]->Write();
-		h_blockcompmaterial_2D[l]->Write();
 
-		outputFile->cd();
-		c_blockcompmaterial_g->cd();
-		g_blockcompmaterial[l]->SetMarkerStyle(34);
-		g_blockcompmaterial[l]->SetMarkerColor(l+1);
-		g_blockcompmaterial[l]->SetMarkerSize(2);
-		g_blockcompmaterial[l]->SetLineColor(l+1);
-		g_blockcompmaterial[l]->SetLineWidth(2);
-		g_blockcompmaterial[l]->SetLineStyle(1);
-		g_blockcompmaterial[l]->Draw("P");
-		sprintf(tempchar, "Material %s", materiallist.at(l).c_str());
-		l_blockcompmaterial_g->AddEntry(g_blockcompmaterial[l],tempchar,"lp");
-		c_blockcompmaterial_g->Update();
+// ********************
+// a function to get the change of every sensor over the window of the stability detector
+// this is the drift of a straight line through the window or the spread of the points around it, whichever is larger
+// ********************
 
-		outputFile->cd();
-		c_blockcompmaterial_g2->cd();
-		g_blockcompmaterial2[l]->SetMarkerStyle(34);
-		g_blockcompmaterial2[l]->SetMarkerColor(l+1);
-		g_blockcompmaterial2[l]->SetMarkerSize(2);
-		g_blockcompmaterial2[l]->SetLineColor(l+1);
-		g_blockcompmaterial2[l]->SetLineWidth(2);
-		g_blockcompmaterial2[l]->SetLineStyle(1);
-		g_blockcompmaterial2[l]->Draw("P");
-		sprintf(tempchar, "Material %s", materiallist.at(l).c_str());
-		l_blockcompmaterial_g2->AddEntry(g_blockcompmaterial2[l],tempchar,"lp");
-		c_blockcompmaterial_g2->Update();
+void windowchange(const stabilitywindow& w, float* deltaT)
+{
 
-		outputFile->cd();
-		c_gradcompmaterial->cd();
-		g_gradcompmaterial[l]->SetMarkerStyle(34);
-		g_gradcompmaterial[l]->SetMarkerColor(l+1);
-		g_gradcompmaterial[l]->SetMarkerSize(2);
-		g_gradcompmaterial[l]->SetLineColor(l+1);
-		g_gradcompmaterial[l]->SetLineWidth(2);
-		g_gradcompmaterial[l]->SetLineStyle(1);
-		g_gradcompmaterial[l]->Draw("P");
-		sprintf(tempchar, "Material %s", materiallist.at(l).c_str());
-		l_gradcompmaterial->AddEntry(g_gradcompmaterial[l],tempchar,"lp");
-		c_gradcompmaterial->Update();
+	double n = w.count;
+	double sxx = w.count > 0 ? w.stt - w.st*w.st/n : 0.0;
+
+	// a window with less than three points or covering less than half of its time is never stable
+	bool filled = w.count >= 3 && sxx > 0.0 && (w.time[(w.first + w.count - 1) % w.time.size()] - w.time[w.first]) >= 0.5*stablewindow;
 
-	} // done material loop int l
-	
-	c_blockcompmaterial_g->cd();
-	l_blockcompmaterial_g->Draw();
-	c_blockcompmaterial_g->Update();
-	c_blockcompmaterial_g->Write();
-	c_blockcompmaterial_g->Close();
-
-	c_blockcompmaterial_g2->cd();
-	l_blockcompmaterial_g2->Draw();
-	c_blockcompmaterial_g2->Update();
-	c_blockcompmaterial_g2->Write();
-	c_blockcompmaterial_g2->Close();
-
-	c_gradcompmaterial->cd();
-	l_gradcompmaterial->Draw();
-	c_gradcompmaterial->Update();
-	c_gradcompmaterial->Write();
-	c_gradcompmaterial->Close();
-	
-	outputFile->cd();
-	TDirectory* calidirectory = outputFile->mkdir("Calibration Comparison");
-	calidirectory->cd();
-//	char tempchar[100];
 	for (int i=0;i<sensors;i++)
 	{
-		h_calicomp[i]->Write();
+		double sxy = w.sty[i] - w.st*w.sy[i]/n;
+		double syy = w.syy[i] - w.sy[i]*w.sy[i]/n;
+		double slope = filled ? sxy/sxx : 0.0;
+		double residual = syy - slope*sxy;
+		double spread = residual > 0.0 ? sqrt(residual/n) : 0.0;
+		double drift = fabs(slope)*stablewindow;
+		deltaT[i] = filled ? (drift > spread ? drift : spread) : 1e30;
+	}
+
+}
+
+
+// ********************
+// a function to evaluate if the change in sensor temperatures is below the given limit -> are we in thermal equilibrium?
+// ********************
+
+bool stablesystem(runstate& state, double mydelta)
+{
+	bool systemstablility = true;
+	for (int i=0;i<sensors;i++)
+	{
+		// with the stability detector the change over its window comes with the point, otherwise compare with the previous point
+		if (stablewindow <= 0.0)
+		{
+			state.deltaT[i] = state.temperature[i] - state.temperaturebefore[i];
+			state.temperaturebefore[i] = state.temperature[i];
+		}
+		// skip non-connected sensors //FIXME
+		if (i != 0 && i!= 9)
+		{
+			if (!(fabs(state.deltaT[i]) <= mydelta))
+			{
+				systemstablility = false;
+				if (debug<1)
+				{
+					state.messages << "System not in thermal equilibrium: deltaT [ " << i << " ] = " << state.deltaT[i] << endl;
+				}
+			}
+		}
+	}
+
+	// the start and the end of a plateau
+	if (systemstablility != state.plateau)
+	{
+		if (debug<3)
+		{
+			state.messages << "Plateau " << (systemstablility ? "starts" : "ends") << " at " << state.time1 << " s!" << endl;
+		}
+		state.plateau = systemstablility;
+	}
+
+	return(systemstablility);
+}
+
+
+// ********************
+// a function to apply the calibration of a run to the sorted temperatures of a point
+// returns the calibration used, or -1 if the average was applied
+// ********************
+
+int applycalibration(int ii, float* temperature, float workingTemperature)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	// if there is a calibration for this specific working temperature, apply it
+	for (int j = 0;j<result.calibs;j++)
+	{
+		// if the working temperature is within 5% of the one used for calibration
+		if ((result.work_Temperature[j] >= (workingTemperature-workingTemperature*0.05)) && (result.work_Temperature[j] <= (workingTemperature+workingTemperature*0.05)))
+		{
+			for (int k = 0;k<sensors;k++)
+			{
+				temperature[k] = temperature[k] - result.calitemp[k][j] + result.work_Temperature[j];
+			}
+			return j;
+		}
+	}
+
+	// use average if no calibration for a working point is found
+	for (int k = 0;k<sensors;k++)
+	{
+		temperature[k] = temperature[k] - result.avg_calitemp[k];
+	}
+	return -1;
+
+}
+
+
+// ********************
+// a function to calculate the temperature difference between neighbouring sensors
+// ********************
+
+void sensordeltas(const float* temperature, float* deltaDT)
+{
+	for (int j = 0;j<sensors;j++)
+	{
+		if (j > 0)
+		{
+			deltaDT[j] = temperature[j] - temperature[j-1];
+		} else {
+			deltaDT[j] = temperature[j] - temperature[9];
+		}
+	}
+}
+
+
+// ********************
+// this function applies the calibration and the sensor differences to all buffered points of a run in one pass
+// gives bit for bit the same numbers as applycalibration and sensordeltas point by point
+// ********************
+
+void calibrateseries(int ii, sampleseries& series)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	size_t n = series.time.size();
+	const float* workingTemperature = series.workingTemperature.data();
+
+	// the calibration for each point, the first one within 5% of its working temperature, or -1 for the average
+	std::vector<int> usedcalibration(n, -1);
+	int* used = usedcalibration.data();
+	for (int j = result.calibs-1;j>=0;j--)
+	{
+		float work = result.work_Temperature[j];
+		for (size_t k = 0;k<n;k++)
+		{
+			bool inside = (work >= (workingTemperature[k]-workingTemperature[k]*0.05)) && (work <= (workingTemperature[k]+workingTemperature[k]*0.05));
+			used[k] = inside ? j : used[k];
+		}
+	}
+
+	// what to subtract and add for each point
+	std::vector<float> offset(n), add(n);
+	for (int j = 0;j<sensors;j++)
+	{
+		float* temperature = series.temperature[j].data();
+		for (size_t k = 0;k<n;k++)
+		{
+			int c = used[k] < 0 ? 0 : used[k];
+			offset[k] = used[k] < 0 ? result.avg_calitemp[j] : result.calitemp[j][c];
+			add[k] = used[k] < 0 ? 0.0f : result.work_Temperature[c];
+		}
+		for (size_t k = 0;k<n;k++)
+		{
+			float calibrated = temperature[k] - offset[k];
+			temperature[k] = used[k] < 0 ? calibrated : calibrated + add[k];
+		}
+	}
+
+	// the temperature difference between neighbouring sensors
+	for (int j = 0;j<sensors;j++)
+	{
+		series.deltaDT[j].resize(n);
+		const float* temperature = series.temperature[j].data();
+		const float* neighbour = series.temperature[j > 0 ? j-1 : sensors-1].data();
+		float* deltaDT = series.deltaDT[j].data();
+		for (size_t k = 0;k<n;k++)
+		{
+			deltaDT[k] = temperature[k] - neighbour[k];
+		}
+	}
+
+	series.calibrated = true;
+
+}
+
+
+// ********************
+// this function reads the next precision-th points of a run into the buffer, with the time applied, at most maxpoints of them
+// ********************
+
+void readblock(runstate& state, sampleseries& series, long int maxpoints)
+{
+
+	// the points before are done
+	series.first += series.time.size();
+	series.entry.clear();
+	series.time.clear();
+	for (int j=0;j<sensors;j++)
+	{
+		series.temperature[j].clear();
+		series.deltaDT[j].clear();
+		series.deltaT[j].clear();
+	}
+	series.current1.clear();
+	series.workingTemperature.clear();
+	series.calibrated = false;
+
+	// the stability detector sees every entry
+	series.windowed = (stablewindow > 0.0);
+
+	// loop over the tuple entries
+	for(; series.nextentry < state.tupleentrycount && (long int)series.time.size() < maxpoints;series.nextentry++)
+	{
+		long int i = series.nextentry;
+
+		// only save every precision-th event
+		bool sample = (i % precision == 0);
+		if (!sample && !series.windowed)
+		{
+			continue;
+		}
+
+		// get the event
+		readentry(state, i);
+
+		if (series.windowed)
+		{
+			pushwindow(state.window, state.uTime, state.temperature);
+		}
+
+		if (sample)
+		{
+
+			// count points for graphs
+			state.usedpoints++;
+
+			// set the time
+			state.time1 = clocktime(state);
+
+			series.entry.push_back(i);
+			series.time.push_back(state.time1);
+			for (int j=0;j<sensors;j++)
+			{
+				series.temperature[j].push_back(state.temperature[j]);
+			}
+			series.current1.push_back(state.current1);
+			series.workingTemperature.push_back(state.workingTemperature);
+
+			// the change of each sensor over the window up to this point
+			if (series.windowed)
+			{
+				windowchange(state.window, state.deltaT);
+				for (int j=0;j<sensors;j++)
+				{
+					series.deltaT[j].push_back(state.deltaT[j]);
+				}
+			}
+
+		} // done precision'th loop 
+	} // done tuple loop
+
+}
+
+
+// ********************
+// this function reads every precision-th point of a run once into a buffer, with the time applied
+// ********************
+
+void readseries(runstate& state, sampleseries& series)
+{
+
+	long int points = (state.tupleentrycount + precision - 1) / precision;
+	series.entry.reserve(points);
+	series.time.reserve(points);
+	for (int j=0;j<sensors;j++)
+	{
+		series.temperature[j].reserve(points);
+	}
+	series.current1.reserve(points);
+	series.workingTemperature.reserve(points);
+
+	if (stablewindow > 0.0)
+	{
+		for (int j=0;j<sensors;j++)
+		{
+			series.deltaT[j].reserve(points);
+		}
+	}
+
+	state.time1 = 0.0;
+	state.usedpoints = 0;
+	readblock(state, series, points);
+
+	if (debug<3)
+	{
+		state.messages << "Buffered " << series.time.size() << " points for calibration and analysis!" << endl;
+		state.messages << " " << endl;
+	}
+
+}
+
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,16,0)
+
+// ********************
+// this function reads the points of a run with RDataFrame: decimation and sorting are columns, calibration and analysis run over the buffer
+// the tuple is split into ranges of whole precision steps, each read in one event loop on its own thread
+// implicit multi-threading is not used, it numbers rdfentry_ in the order the clusters are done, not by tuple entry
+// ********************
+
+void rdataframeseries(int ii, runstate& state, sampleseries& series)
+{
+
+	typedef ROOT::VecOps::RVec<float> floats;
+
+	// the branches in sorted order
+	std::vector<std::string> sortedbranches;
+	for (int j=0;j<sensors;j++)
+	{
+		sortedbranches.push_back(Form("temperature%d", sortorder.at(ii).at(j)));
+	}
+
+	// the ranges of the tuple, one per thread
+	long int points = (state.tupleentrycount + precision - 1) / precision;
+	int nranges = threadcount(points);
+	long int rangelength = ((points + nranges - 1) / nranges) * precision;
+
+	// what each range gives back: all time stamps for the clock, the tuple entry and the columns of the points
+	std::vector<std::vector<unsigned int> > rangetimes(nranges);
+	std::vector<std::vector<ULong64_t> > rangeentries(nranges);
+	std::vector<std::vector<unsigned int> > rangesampletimes(nranges);
+	std::vector<std::vector<floats> > rangetemperatures(nranges);
+	std::vector<std::vector<float> > rangecurrents(nranges), rangeworkings(nranges);
+
+	// the compressed bytes read by all event loops of this run, the runs are analysed one at a time
+	long long bytesread = TFile::GetFileBytesRead();
+
+	int step = precision;
+	parallelfor(nranges, [&](int r, int)
+	{
+		ULong64_t begin = (ULong64_t)r * rangelength;
+		ULong64_t end = std::min((ULong64_t)state.tupleentrycount, begin + rangelength);
+
+		// in a single-threaded loop rdfentry_ is the entry of the tuple
+		ROOT::RDataFrame frame("thermoDAQ", filelist.at(ii));
+		ROOT::RDF::RNode range = frame.Range(begin, end);
+
+		// only every precision-th event
+		ROOT::RDF::RNode node = range.Filter([step](ULong64_t entry) { return entry % step == 0; }, {"rdfentry_"});
+
+		// the sensors in sorted order
+		node = node.Define("sorted", [](float t0, float t1, float t2, float t3, float t4, float t5, float t6, float t7, float t8, float t9)
+		{
+			floats sorted(sensors);
+			sorted[0] = t0; sorted[1] = t1; sorted[2] = t2; sorted[3] = t3; sorted[4] = t4;
+			sorted[5] = t5; sorted[6] = t6; sorted[7] = t7; sorted[8] = t8; sorted[9] = t9;
+			return sorted;
+		}, sortedbranches);
+
+		// book everything before running
+		ROOT::RDF::RResultPtr<std::vector<unsigned int> > times = range.Take<unsigned int>("uTime");
+		ROOT::RDF::RResultPtr<std::vector<ULong64_t> > entries = node.Take<ULong64_t>("rdfentry_");
+		ROOT::RDF::RResultPtr<std::vector<unsigned int> > sampletimes = node.Take<unsigned int>("uTime");
+		ROOT::RDF::RResultPtr<std::vector<floats> > temperatures = node.Take<floats>("sorted");
+		ROOT::RDF::RResultPtr<std::vector<float> > currents = node.Take<float>("current1");
+		ROOT::RDF::RResultPtr<std::vector<float> > workings = node.Take<float>("workingTemperature");
+
+		// this runs the event loop, the points come back in tuple order
+		rangetimes.at(r).swap(*times);
+		rangeentries.at(r).swap(*entries);
+		rangesampletimes.at(r).swap(*sampletimes);
+		rangetemperatures.at(r).swap(*temperatures);
+		rangecurrents.at(r).swap(*currents);
+		rangeworkings.at(r).swap(*workings);
+	});
+
+	// rdataframe does not tell how many bytes it decompressed, only the bytes read are counted
+	state.bytesread = TFile::GetFileBytesRead() - bytesread;
+	state.bytesunzipped = 0;
+
+	// the time of the whole run, from the time stamps of all entries in order
+	for (int r=0;r<nranges;r++)
+	{
+		checktimes(state.clock, rangetimes.at(r).data(), rangetimes.at(r).size());
+		std::vector<unsigned int>().swap(rangetimes.at(r));
+	}
+	reportclock(state);
+
+	// the time needs the points in order
+	state.time1 = 0.0;
+	state.usedpoints = 0;
+	series.calibrated = false;
+	series.entry.reserve(points);
+	series.time.reserve(points);
+	for (int r=0;r<nranges;r++)
+	{
+		for (size_t o=0;o<rangeentries.at(r).size();o++)
+		{
+			state.uTime = rangesampletimes.at(r)[o];
+			state.usedpoints++;
+			state.time1 = clocktime(state);
+
+			series.entry.push_back(rangeentries.at(r)[o]);
+			series.time.push_back(state.time1);
+			for (int j=0;j<sensors;j++)
+			{
+				series.temperature[j].push_back(rangetemperatures.at(r)[o][j]);
+			}
+			series.current1.push_back(rangecurrents.at(r)[o]);
+			series.workingTemperature.push_back(rangeworkings.at(r)[o]);
+		}
+	}
+
+	if (debug<3)
+	{
+		state.messages << "RDataFrame returned " << series.time.size() << " points from " << nranges << " ranges of the tuple!" << endl;
+		state.messages << " " << endl;
+	}
+	if (debug<4)
+	{
+		state.messages << "Read " << state.bytesread << " bytes from the input file with RDataFrame!" << endl;
+		state.messages << " " << endl;
+	}
+
+}
+
+#endif
+
+
+// ********************
+// this function starts a pass over the buffered points of a run
+// a streamed series is read again from the first entry, with an empty window for the stability detector
+// ********************
+
+void restartseries(runstate& state, sampleseries& series)
+{
+	series.done = false;
+	if (series.streamed)
+	{
+		series.first = 0;
+		series.nextentry = 0;
+		series.time.clear();
+		state.window = stabilitywindow();
+	}
+}
+
+
+// ********************
+// this function gives the next block of buffered points of a run: all points of a buffered run at once,
+// the next serieschunk points of a streamed one, calibrated for the analysis with the block kernel
+// ********************
+
+bool nextblock(int ii, runstate& state, sampleseries& series, bool analysis)
+{
+	if (!series.streamed)
+	{
+		bool more = !series.done;
+		series.done = true;
+		return more;
+	}
+	readblock(state, series, serieschunk);
+	if (analysis && kernel == 1 && !series.time.empty())
+	{
+		calibrateseries(ii, series);
+	}
+	return !series.time.empty();
+}
+
+
+// ********************
+// this function puts the k-th buffered point of a run into the state, as if it was just read from the tuple
+// ********************
+
+void loadsample(runstate& state, const sampleseries& series, size_t k)
+{
+	state.usedpoints = series.first + k + 1;
+	state.time1 = series.time[k];
+	for (int j=0;j<sensors;j++)
+	{
+		state.temperature[j] = series.temperature[j][k];
+	}
+	state.current1 = series.current1[k];
+	state.workingTemperature = series.workingTemperature[k];
+	if (series.calibrated)
+	{
+		for (int j=0;j<sensors;j++)
+		{
+			state.deltaDT[j] = series.deltaDT[j][k];
+		}
+	}
+	if (series.windowed)
+	{
+		for (int j=0;j<sensors;j++)
+		{
+			state.deltaT[j] = series.deltaT[j][k];
+		}
+	}
+}
+
+
+// ********************
+// this function looks for a calibration point at one measurement point of a run
+// ********************
+
+void calibrationstep(int ii, runstate& state, long int i)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	// now we analyse all calbration parts, there are 'calibs' of these.
+
+	// there has to be a change of the bath temperature, then we start to look for a calibration point
+	if (state.workingTemperature != state.workingTemperaturebefore && state.inbetween*precision > calibrationgap)
+	{
+		state.lookForCal = true;
+		if (debug<3)
+		{
+			state.messages << "Searching for calibration at time: " << state.time1 << endl;
+			state.messages << "Current working temperature is: " << state.workingTemperature << endl;
+			state.messages << "Measurement points since last search: " << state.inbetween << endl;
+			state.messages << " " << endl;
+		}
+		state.inbetween=0;
+	}
+
+	// make sure there is a gap between the calibrations
+	if(state.inbetween*precision > calibrationgap + precision)
+	{
+		state.workingTemperaturebefore = state.workingTemperature;
+	}
+
+	// the heater has to be off
+	if (state.lookForCal && state.current1 == 0)
+	{
+		state.insidecool = true;
+		if (debug<3)
+		{
+			state.messages << "Performing search!" << endl;
+			state.messages << "Measurement time is: " << state.time1 << endl;
+			state.messages << "Tuple point is: " << i << endl;
+			state.messages << " " << endl;
+		}
+
+		state.insidecool = stablesystem(state, deltacali);
+
+		// if alle sensors are good, then we add all temperatures to the calitemp
+		if (state.insidecool)
+		{
+			if (debug<3)
+			{
+				state.messages << "All deltaTs are good!" << endl;
+			}
+
+			for (int j = 0; j < sensors ; j++)
+			{
+				result.calitemp[j].push_back(state.temperature[j]);
+				if (debug<4)
+				{
+					state.messages << "Calibration point " << result.calitemp[j][result.calibs] << " at working temperature " << state.workingTemperature << endl;
+				}
+			}
+			result.calitime.push_back(state.time1);
+			result.work_Temperature.push_back(state.workingTemperature);
+			state.lookForCal = false;
+			if (debug<4)
+			{
+				state.messages << " " << endl;
+				state.messages << "Done " << result.calibs + 1 << " calibrations!" << endl;
+				state.messages << " " << endl;
+			}
+			result.calibs++;
+		}
+	}
+
+}
+
+
+// ********************
+// this function averages the calibrations of a run found so far
+// ********************
+
+void averagecalibration(int ii, runstate& state)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	if (debug<4)
+	{
+		state.messages << "Averaging calibration points of " << result.calibs << " calibrations!" <<endl;
+	}
+
+	float* avg_cali_error = result.avg_calierror;
+	for (int j = 0; j < sensors; j++)
+	{
+		// get the average
+		result.avg_calitemp[j] = 0.0;
+		avg_cali_error[j] = 0.0;
+		for (int k=0;k<result.calibs;k++)
+		{
+			result.avg_calitemp[j] += result.calitemp[j][k]-result.work_Temperature[k];
+		}
+		result.avg_calitemp[j] /= result.calibs;
+
+		// get the standard deviation
+		for (int k=0;k<result.calibs;k++)
+		{
+			avg_cali_error[j] += (result.avg_calitemp[j] - (result.calitemp[j][k]-result.work_Temperature[k]))*(result.avg_calitemp[j] - (result.calitemp[j][k]-result.work_Temperature[k]));
+		}
+		avg_cali_error[j] /= result.calibs;
+		avg_cali_error[j] = sqrt(avg_cali_error[j]);
+		if (debug<4)
+		{
+			state.messages << "Average calibration of sensor " << j << " is " << result.avg_calitemp[j] << " +- " << avg_cali_error[j] << " deg C." << endl;
+		}
+	}
+	if (debug<4)
+	{
+		state.messages << " " << endl;
+	}
+
+}
+
+
+// ********************
+// this function runs the calibration of a measurement: look for stable points while the heater is off
+// ********************
+
+void calibraterun(int ii, runstate& state, sampleseries* series)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	state.time1 = 0.0;
+	state.usedpoints = 0;
+
+	if (debug<5)
+	{
+		state.messages << " " << endl;
+		state.messages << "********************" << endl;
+		state.messages << "Running calibration!" << endl;
+		state.messages << "********************" << endl;
+		state.messages << " " << endl;
+	}
+
+	// the points are already read, sorted and buffered, or read again in blocks
+	if (series != 0)
+	{
+		restartseries(state, *series);
+		while (nextblock(ii, state, *series, false))
+		{
+			for (size_t k = 0; k < series->time.size(); k++)
+			{
+				// to make sure there is a gap in between the calibrations, count points between
+				state.inbetween++;
+
+				// get the point from the buffer
+				loadsample(state, *series, k);
+
+				calibrationstep(ii, state, series->entry[k]);
+			}
+		}
+	} else {
+
+		// loop over all tuple entries
+		for(int i = 0; i < state.tupleentrycount;i++)
+		{
+			// only save every precision-th event
+			if (i % precision == 0)
+			{
+
+				// to make sure there is a gap in between the calibrations, count points between
+				state.inbetween++;
+
+				// get the event
+				readentry(state, i);
+
+				// count points for graphs
+				state.usedpoints++;
+
+				// set the time
+				state.time1 = clocktime(state);
+
+				calibrationstep(ii, state, i);
+
+			} // done precision'th loop 
+		} // done tuple loop
+
+	}
+
+	// so now we can average the calitemps 
+	if (result.calibs > 0)
+	{
+		averagecalibration(ii, state);
+
+	// if no calibrations were found, we have a bad measurement!
+	} else {
+		if (debug<5)
+		{
+			state.messages << "No possible calibration point found in run " << ii << "!" << endl;
+			state.messages << "Aborting run!" << endl;
+			state.messages << " " << endl;
+		}
+		result.aborted = true;
+	}
+
+}
+
+
+// ********************
+// a function to pick the points of a time series that keep its shape in a plot: largest triangle three buckets
+// the first and the last point are kept, from each bucket in between the point spanning the largest triangle
+// with the point picked before and the average of the next bucket
+// ********************
+
+void downsample(const std::vector<double>& x, const std::vector<float>& y, size_t target, std::vector<size_t>& picked)
+{
+
+	picked.clear();
+	size_t n = x.size();
+
+	// nothing to do, readoptions only allows 0 or at least 3 points
+	if (target == 0 || target >= n || target < 3)
+	{
+		for (size_t k=0;k<n;k++)
+		{
+			picked.push_back(k);
+		}
+		return;
+	}
+
+	picked.reserve(target);
+	double bucket = double(n-2)/(target-2);
+	size_t a = 0;
+	picked.push_back(a);
+	for (size_t b=0;b<target-2;b++)
+	{
+		// the average of the next bucket, the last point for the last bucket
+		size_t nextstart = (size_t)((b+1)*bucket) + 1;
+		size_t nextend = (size_t)((b+2)*bucket) + 1;
+		if (nextend > n)
+		{
+			nextend = n;
+		}
+		double avgx = 0.0;
+		double avgy = 0.0;
+		for (size_t k=nextstart;k<nextend;k++)
+		{
+			avgx += x[k];
+			avgy += y[k];
+		}
+		avgx /= (nextend - nextstart);
+		avgy /= (nextend - nextstart);
+
+		// the point of this bucket with the largest triangle
+		size_t start = (size_t)(b*bucket) + 1;
+		size_t end = (size_t)((b+1)*bucket) + 1;
+		double maxarea = -1.0;
+		size_t maxpoint = start;
+		for (size_t k=start;k<end;k++)
+		{
+			double area = fabs((x[a] - avgx)*(y[k] - y[a]) - (x[a] - x[k])*(avgy - y[a]));
+			if (area > maxarea)
+			{
+				maxarea = area;
+				maxpoint = k;
+			}
+		}
+		picked.push_back(maxpoint);
+		a = maxpoint;
+	}
+	picked.push_back(n-1);
+
+}
+
+
+// ********************
+// this function opens the series of a run: a tree with one entry per analysed point, written in chunks while the run is analysed
+// ********************
+
+void openseries(int ii, runstate& state)
+{
+
+	if (seriesmode == 0)
+	{
+		return;
+	}
+
+	// each run has its own file, so runs analysed at once do not share one
+	mkdir(seriesdir.c_str(), 0755);
+	char tempchar[100];
+	sprintf(tempchar, "/run%i.root", ii);
+	std::string name = seriesdir + tempchar;
+	state.seriesfile = new TFile(name.c_str(), "RECREATE");
+	if (state.seriesfile->IsZombie())
+	{
+		cout << "Error writing the series file " << name << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	if (compression >= 0)
+	{
+		state.seriesfile->SetCompressionSettings(compression);
+	}
+
+	// the columns point at the state, each point is filled as it is analysed
+	state.seriestree = new TTree("series", filelist.at(ii).c_str());
+	state.seriestree->SetDirectory(state.seriesfile);
+	state.seriestree->SetAutoFlush(serieschunk);
+	state.seriestree->Branch("entry", &state.seriesentry, "entry/L");
+	state.seriestree->Branch("time", &state.time1, "time/D");
+	state.seriestree->Branch("temperature", state.temperature, Form("temperature[%d]/F", sensors));
+	state.seriestree->Branch("deltaDT", state.deltaDT, Form("deltaDT[%d]/F", sensors));
+	state.seriestree->Branch("current1", &state.current1, "current1/F");
+	state.seriestree->Branch("workingTemperature", &state.workingTemperature, "workingTemperature/F");
+	state.seriestree->Branch("plateau", &state.seriesplateau, "plateau/O");
+	state.seriestree->Branch("stable", &state.seriesstable, "stable/O");
+	state.seriestree->Branch("stablepoint", &state.seriespoint, "stablepoint/I");
+
+}
+
+
+// ********************
+// this function writes the rest of the series of a run and closes its file
+// ********************
+
+void closeseries(runstate& state)
+{
+
+	if (state.seriesfile == 0)
+	{
+		return;
+	}
+
+	long long points = state.seriestree->GetEntries();
+	state.seriesfile->cd();
+	state.seriestree->Write();
+	state.seriesfile->Close();
+	delete state.seriesfile;
+	state.seriesfile = 0;
+	state.seriestree = 0;
+
+	if (debug<4)
+	{
+		state.messages << "Wrote " << points << " points into the series of the run!" << endl;
+		state.messages << " " << endl;
+	}
+
+}
+
+
+// ********************
+// this function thins the points kept for the time graphs to those any of the downsampled graphs would show
+// with a series the points are on disk, so the time graphs only need their shape
+// ********************
+
+void compactplot(runstate& state)
+{
+
+	std::vector<size_t> picked, keep;
+	for (int j=0;j<sensors;j++)
+	{
+		downsample(state.plottime, state.plottemperature[j], plotpoints, picked);
+		keep.insert(keep.end(), picked.begin(), picked.end());
+		downsample(state.plottime, state.plotdeltaDT[j], plotpoints, picked);
+		keep.insert(keep.end(), picked.begin(), picked.end());
+	}
+	std::sort(keep.begin(), keep.end());
+	keep.erase(std::unique(keep.begin(), keep.end()), keep.end());
+
+	// the kept points move to the front, in order
+	for (size_t k=0;k<keep.size();k++)
+	{
+		state.plottime[k] = state.plottime[keep[k]];
+		for (int j=0;j<sensors;j++)
+		{
+			state.plottemperature[j][k] = state.plottemperature[j][keep[k]];
+			state.plotdeltaDT[j][k] = state.plotdeltaDT[j][keep[k]];
+		}
+	}
+	state.plottime.resize(keep.size());
+	for (int j=0;j<sensors;j++)
+	{
+		state.plottemperature[j].resize(keep.size());
+		state.plotdeltaDT[j].resize(keep.size());
+	}
+
+}
+
+
+// ********************
+// this function applies the calibration at one measurement point of a run and checks if it is a stable gradient point
+// ********************
+
+void analysisstep(int ii, runstate& state, long int i, bool applied)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	// the points of the rdataframe backend and the block kernel come calibrated already
+	if (!applied)
+	{
+
+		// apply calibration
+		// use average if no calibration for a working point is found
+		int usedcalibration = applycalibration(ii, state.temperature, state.workingTemperature);
+		if (debug<1)
+		{
+			if (usedcalibration >= 0)
+			{
+				state.messages << "Found correct calibration at point " << usedcalibration << " with " << result.work_Temperature[usedcalibration] << " deg C!" << endl;
+			} else {
+				state.messages << "Did not find correct calibration, applying average!" << endl;
+			}
+		}
+
+		// the temperature difference between different sensors
+		sensordeltas(state.temperature, state.deltaDT);
+
+	}
+
+	// print some output
+	if (debug<0)
+	{
+		state.messages << "Data point: " << i << " , temperatures: " << state.temperature[0] << " " << state.temperature[1] << " " << state.temperature[2] << " " << state.temperature[3] << " " << state.temperature[4] << " " << state.temperature[5] << " " << state.temperature[6] << " " << state.temperature[7] << " " << state.temperature[8] << " " << state.temperature[9] <<" at time: " << state.time1 <<  endl;
+		state.messages << "DeltaDT is: " << state.deltaDT[0] << " " << state.deltaDT[1] << " " << state.deltaDT[2] << " " << state.deltaDT[3] << " " << state.deltaDT[4] << " " << state.deltaDT[5] << " " << state.deltaDT[6] << " " << state.deltaDT[7] << " " << state.deltaDT[8] << " " << state.deltaDT[9] << endl;
+	}
+
+	// keep the point for the time graphs
+	state.plottime.push_back(state.time1);
+	for (int j=0;j<sensors;j++)
+	{
+		state.plottemperature[j].push_back(state.temperature[j]);
+		state.plotdeltaDT[j].push_back(state.deltaDT[j]);
+	}
+	if (state.seriestree != 0 && plotpoints > 0 && state.plottime.size() >= (size_t)seriescompact*plotpoints)
+	{
+		compactplot(state);
+	}
+	int points = result.stablepoints;
+
+	// are we in thermal equilibrium?
+	bool plateau = state.plateau;
+	state.insidecool = stablesystem(state, deltagrad);
+	if (state.plateau && !plateau)
+	{
+		result.plateaustart.push_back(state.time1);
+	}
+	if (!state.plateau && plateau)
+	{
+		result.plateauend.push_back(state.time1);
+	}
+	if (state.insidecool)
+	{
+		state.inbetween++;
+	}
+
+	// require >2 stable points between actual points, also current on
+	if (state.insidecool && (state.inbetween*precision > gradientgap) && state.current1 > 0.0)
+	{
+		for (int j = 0; j < sensors ; j++)
+		{
+			result.stabletemp[j].push_back(state.temperature[j]);
+		}
+		if (debug<3)
+		{
+			state.messages << "Found stable point no. " << result.stablepoints << " at " << state.time1 << " s!" << endl;
+		}
+
+		// save working temperature, current and time
+		result.stablework.push_back(state.workingTemperature);
+		result.stablecurrent.push_back(state.current1);
+		result.stabletime.push_back(state.time1);
+
+		// increase the count
+		result.stablepoints++;
+
+		// reset the distance counter
+		state.inbetween = 0;
+	}
+
+	// stream the point into the series of the run
+	if (state.seriestree != 0)
+	{
+		state.seriesentry = i;
+		state.seriesstable = state.insidecool;
+		state.seriesplateau = state.plateau;
+		state.seriespoint = (result.stablepoints > points) ? points : -1;
+		state.seriestree->Fill();
+	}
+
+}
+
+
+// ********************
+// this function fits straight lines to the sensors of one block for all stable points of a run at once
+// weighted least squares in closed form, the position error is folded into the weights as an effective variance
+// with the slope of the pass before, repeated until the slope no longer changes
+// this is an approximation of a TGraphErrors fit, which also minimises over the slope in the weights: --fitcheck compares them
+// ********************
+
+void fitlines(const std::vector<float>* temperature, unsigned int broken, double xmin, double xmax, linefits& fits)
+{
+
+	size_t n = temperature[1].size();
+
+	// the sums over the sensors, one per stable point
+	std::vector<double> s(n), sx(n), sy(n), sxx(n), sxy(n);
+
+	// the slope for the effective variance, the first pass uses the temperature errors only
+	std::vector<double> slope(n, 0.0);
+	std::vector<double> offset(n, 0.0);
+
+	// the sensors in the range of this block
+	int npoints = 0;
+	for (int k=1;k<=8;k++)
+	{
+		if (!(broken & (1u << k)) && sensorposition[k-1] >= xmin && sensorposition[k-1] <= xmax)
+		{
+			npoints++;
+		}
+	}
+
+	bool converged = false;
+	for (int iteration=0;iteration<fititerations && !converged;iteration++)
+	{
+
+		std::fill(s.begin(), s.end(), 0.0);
+		std::fill(sx.begin(), sx.end(), 0.0);
+		std::fill(sy.begin(), sy.end(), 0.0);
+		std::fill(sxx.begin(), sxx.end(), 0.0);
+		std::fill(sxy.begin(), sxy.end(), 0.0);
+
+		// sensor by sensor, so the inner loop runs over the stable points
+		for (int k=1;k<=8;k++)
+		{
+			double x = sensorposition[k-1];
+			if ((broken & (1u << k)) || x < xmin || x > xmax)
+			{
+				continue;
+			}
+			const float* y = temperature[k].data();
+			for (size_t j=0;j<n;j++)
+			{
+				double ey = y[j]*errorpercentage;
+				double variance = ey*ey + slope[j]*slope[j]*positionerror*positionerror;
+				double w = variance > 0.0 ? 1.0/variance : 0.0;
+				s[j] += w;
+				sx[j] += w*x;
+				sy[j] += w*y[j];
+				sxx[j] += w*x*x;
+				sxy[j] += w*x*y[j];
+			}
+		}
+
+		converged = true;
+		for (size_t j=0;j<n;j++)
+		{
+			double before = slope[j];
+			double det = s[j]*sxx[j] - sx[j]*sx[j];
+			if (det > 0.0)
+			{
+				slope[j] = (s[j]*sxy[j] - sx[j]*sy[j])/det;
+				offset[j] = (sxx[j]*sy[j] - sx[j]*sxy[j])/det;
+			} else {
+				slope[j] = 0.0;
+				offset[j] = 0.0;
+			}
+			converged = converged && fabs(slope[j] - before) <= 1e-12*std::max(1.0, fabs(slope[j]));
+		}
+
+	}
+
+	fits.offset = offset;
+	fits.slope = slope;
+	fits.covoffset.assign(n, 0.0);
+	fits.covmixed.assign(n, 0.0);
+	fits.covslope.assign(n, 0.0);
+	fits.chi2.assign(n, 0.0);
+	fits.ndf.assign(n, npoints-2);
+	for (size_t j=0;j<n;j++)
+	{
+		double det = s[j]*sxx[j] - sx[j]*sx[j];
+		if (det > 0.0)
+		{
+			fits.covoffset[j] = sxx[j]/det;
+			fits.covmixed[j] = -sx[j]/det;
+			fits.covslope[j] = s[j]/det;
+		}
+	}
+
+	// the chi2 with the final weights
+	for (int k=1;k<=8;k++)
+	{
+		double x = sensorposition[k-1];
+		if ((broken & (1u << k)) || x < xmin || x > xmax)
+		{
+			continue;
+		}
+		const float* y = temperature[k].data();
+		for (size_t j=0;j<n;j++)
+		{
+			double ey = y[j]*errorpercentage;
+			double variance = ey*ey + slope[j]*slope[j]*positionerror*positionerror;
+			double residual = y[j] - offset[j] - slope[j]*x;
+			fits.chi2[j] += variance > 0.0 ? residual*residual/variance : 0.0;
+		}
+	}
+
+}
+
+
+// ********************
+// this function fits the gradients in both blocks at all stable points of a run and gets the temperature difference at the interface
+// ********************
+
+void fitgradients(int ii)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	// the lower block is below 40 mm, the upper block above
+	fitlines(result.stabletemp, brokenmask.at(ii), 0.0, 40.1, result.fitlow);
+	fitlines(result.stabletemp, brokenmask.at(ii), 39.9, 80.0, result.fithigh);
+	profiles.at(ii).fits = result.fitlow.ndf.size() + result.fithigh.ndf.size();
+
+	result.tempdiff.resize(result.stablepoints);
+	result.tempdifftemp.resize(result.stablepoints);
+	for (int j=0;j<result.stablepoints;j++)
+	{
+		// calculate the temperature difference from the fit difference
+		float lowtemp = result.fitlow.offset[j] + result.fitlow.slope[j]*40.0 + greasetemp/2.0;
+		float hightemp = result.fithigh.offset[j] + result.fithigh.slope[j]*40.0 - greasetemp/2.0;
+		result.tempdiff[j] = hightemp - lowtemp;
+
+		// define the measurement temperature of this as the average between top and bottom blocks
+		result.tempdifftemp[j] = (hightemp + lowtemp)/2.0;
+	}
+
+}
+
+
+// ********************
+// this function keeps the analysed points of a run for the time graphs, downsampled to at most plotpoints points each
+// ********************
+
+void fillgraphs(int ii, runstate& state)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	std::vector<size_t> picked;
+	for (int j=0;j<sensors;j++)
+	{
+		downsample(state.plottime, state.plottemperature[j], plotpoints, picked);
+		for (size_t k=0;k<picked.size();k++)
+		{
+			result.graphtime[j].push_back(state.plottime[picked[k]]);
+			result.graphtemperature[j].push_back(state.plottemperature[j][picked[k]]);
+		}
+
+		downsample(state.plottime, state.plotdeltaDT[j], plotpoints, picked);
+		for (size_t k=0;k<picked.size();k++)
+		{
+			result.deltagraphtime[j].push_back(state.plottime[picked[k]]);
+			result.graphdeltaDT[j].push_back(state.plotdeltaDT[j][picked[k]]);
+		}
+	}
+
+	if (debug<3 && picked.size() < state.plottime.size())
+	{
+		state.messages << "Time graphs show " << picked.size() << " of " << state.plottime.size() << " points!" << endl;
+	}
+
+	// the points are in the graphs now
+	state.plottime.clear();
+	for (int j=0;j<sensors;j++)
+	{
+		state.plottemperature[j].clear();
+		state.plotdeltaDT[j].clear();
+	}
+
+}
+
+
+// ********************
+// this function runs the analysis of a measurement: apply the calibration and look for stable gradient points
+// ********************
+
+void analyserun(int ii, runstate& state, sampleseries* series)
+{
+
+	if (debug<5)
+	{
+		state.messages << " " << endl;
+		state.messages << "********************" << endl;
+		state.messages << "Running analysis!" << endl;
+		state.messages << "********************" << endl;
+		state.messages << " " << endl;
+	}
+
+	state.time1 = 0.0;
+	state.usedpoints = 0;
+
+	for (int j=0;j<sensors;j++)
+	{
+		state.temperaturebefore[j] = 0.0;
+	}
+	state.insidecool = false;
+	state.plateau = false;
+	state.inbetween = 0;
+
+	double starttime = walltime();
+	openseries(ii, state);
+
+	// the points are already read, sorted and buffered, or read again in blocks
+	if (series != 0)
+	{
+		restartseries(state, *series);
+		while (nextblock(ii, state, *series, true))
+		{
+			for (size_t k = 0; k < series->time.size(); k++)
+			{
+				// get the point from the buffer
+				loadsample(state, *series, k);
+
+				analysisstep(ii, state, series->entry[k], series->calibrated);
+			}
+		}
+	} else {
+
+		// loop over all tuple entries
+		for(int i = 0; i < state.tupleentrycount;i++)
+		{
+			// only save every precision-th event
+			if (i % precision == 0)
+			{
+
+				// get the event
+				readentry(state, i);
+
+				// count points for graphs
+				state.usedpoints++;
+
+				// set the time
+				state.time1 = clocktime(state);
+
+				analysisstep(ii, state, i, false);
+
+			} // done precision'th loop 
+		} // done tuple loop
+
+	}
+
+	if (debug<4)
+	{
+		state.messages << "Done tuple loop, plotting output!" << endl;
+		state.messages << "Found " << results[ii].stablepoints << " gradient points on " << results[ii].plateaustart.size() << " plateaus!" << endl;
+		state.messages << " " << endl;
+	}
+
+	closeseries(state);
+	stagedone(profiles.at(ii), stageanalysis, starttime);
+
+	// the fits only need the stable points
+	starttime = walltime();
+	fitgradients(ii);
+	stagedone(profiles.at(ii), stagefits, starttime);
+
+	// the plots only need the shape
+	fillgraphs(ii, state);
+
+}
+
+
+// ********************
+// this function only loops the tuple of a measurement, for testing
+// ********************
+
+void testrun(runstate& state)
+{
+
+	if (debug<5)
+	{
+		state.messages << " " << endl;
+		state.messages << "********************" << endl;
+		state.messages << "Running testing!" << endl;
+		state.messages << "********************" << endl;
+		state.messages << " " << endl;
+	}
+
+	// loop over all tuple entries
+	for(int ij = 0; ij < state.tupleentrycount;ij++)
+	{
+		// only save every precision-th event
+		if (ij % precision == 0)
+		{
+
+			// count points for graphs
+			state.usedpoints++;
+
+			//make sure, there is a gap in between the calibrations
+			state.inbetween++;
+
+			// get the event
+			readentry(state, ij);
+
+			
+		} // done precision'th loop 
+	} // done tuple loop
+
+}
+
+
+// ********************
+// this function does all the tuple work of one measurement run, it only touches the state and results of this run
+// ********************
+
+void processrun(int ii, runstate& state)
+{
+
+	// open the file
+	double starttime = walltime();
+	openfile(ii, state);
+	stagedone(profiles.at(ii), stageopen, starttime);
+
+	// let's go!
+
+	// calibration and analysis from one pass over the tuple
+	sampleseries* series = 0;
+	// with a series the memory of a run does not grow with its length: calibration and analysis each read the run in blocks
+	if (backend == 0 && seriesmode == 1 && mode >= 1 && mode <= 3)
+	{
+		series = new sampleseries();
+		series->streamed = true;
+	// the stability detector needs every entry, so it always reads into a buffer
+	} else if (backend == 0 && ((mode == 3 && fused == 1) || ((mode == 1 || mode == 2 || mode == 3) && stablewindow > 0.0))) {
+		starttime = walltime();
+		series = new sampleseries();
+		readseries(state, *series);
+		stagedone(profiles.at(ii), stageread, starttime);
+	}
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,16,0)
+	// the rdataframe backend reads the tuple once, calibration and analysis run over its points
+	if (backend == 1 && mode >= 1 && mode <= 3)
+	{
+		starttime = walltime();
+		series = new sampleseries();
+		rdataframeseries(ii, state, *series);
+		stagedone(profiles.at(ii), stageread, starttime);
+	}
+#endif
+
+	// mode selection, 1 = calibration, 3 = calibration and analysis
+	if (mode == 1 || mode == 3)
+	{
+		starttime = walltime();
+		calibraterun(ii, state, series);
+		stagedone(profiles.at(ii), stagecalibration, starttime);
+	}
+
+	// mode selection, 2 = analysis, 3 = calibration and analysis
+	if ((mode == 2 || mode == 3) && !results[ii].aborted)
+	{
+		// calibrate all points of the run as one block, the rdataframe points always are, a streamed run block by block
+		if ((kernel == 1 || backend == 1) && !(series != 0 && series->streamed))
+		{
+			if (series == 0)
+			{
+				starttime = walltime();
+				series = new sampleseries();
+				readseries(state, *series);
+				stagedone(profiles.at(ii), stageread, starttime);
+			}
+			starttime = walltime();
+			calibrateseries(ii, *series);
+			stagedone(profiles.at(ii), stageanalysis, starttime);
+		}
+		analyserun(ii, state, series);
+	}
+
+	delete series;
+
+	if (mode == 0)
+	{
+		testrun(state);
+	}
+
+	// catch wrong mode entry
+	if ( mode < 0 || mode > 3)
+	{
+		state.messages << "Wrong value for mode! Allowed settings are:" << endl;
+		state.messages << " 0 - Testing" << endl;
+		state.messages << " 1 - Calibration" << endl;
+		state.messages << " 2 - Analysis" << endl;
+		state.messages << " 3 - Calibration and analysis" << endl;
+	}
+
+	// we're done with a file
+	closefile(state);
+
+}
+
+
+// ********************
+// this function plots the calibrations of a measurement
+// ********************
+
+void plotcalibration(int ii)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	bookcalibrationplot(ii);
+
+	// draw
+	if (headless == 0)
+	{
+		c_cali[ii]->cd();
+		h_cali[ii]->Draw("");
+	}
+
+	// plot the output
+	int pointsep = -1;
+	for (int j=0;j<result.calibs;j++)
+	{
+		for (int k = 0; k < sensors ; k++)
+		{
+			// shift the point for plotting
+			calibrationgraph[ii][j]->SetPoint(k, k-(j/2 + 1)*0.1*pointsep,  result.calitemp[k][j]-result.work_Temperature[j]);
+			calibrationgraph[ii][j]->SetPointError(k, 0,  (result.calitemp[k][j]-result.work_Temperature[j])*errorpercentage);
+		}
+		pointsep = pointsep*(-1);
+
+		calibrationgraph[ii][j]->SetMarkerStyle(34);
+		calibrationgraph[ii][j]->SetMarkerColor(j+1);
+		calibrationgraph[ii][j]->SetMarkerSize(2);
+		calibrationgraph[ii][j]->SetLineColor(j+1);
+		calibrationgraph[ii][j]->SetLineWidth(2);
+		calibrationgraph[ii][j]->SetLineStyle(1);
+		if (headless == 1)
+		{
+			calibrationgraph[ii][j]->Write();
+			continue;
+		}
+		c_cali[ii]->cd();
+		calibrationgraph[ii][j]->Draw("P");
+		char tempchar[100];
+		sprintf(tempchar, "%.1f #circC", result.work_Temperature[j]);
+		l_cali[ii]->AddEntry(calibrationgraph[ii][j],tempchar,"lp");
+	}
+	for (int k = 0; k < sensors ; k++)
+	{
+		avg_calibrationgraph[ii]->SetPoint(k, k, result.avg_calitemp[k]);
+		avg_calibrationgraph[ii]->SetPointError(k, 0, result.avg_calierror[k]);
+	}
+	avg_calibrationgraph[ii]->SetMarkerStyle(34);
+	avg_calibrationgraph[ii]->SetMarkerColor(result.calibs+1);
+	avg_calibrationgraph[ii]->SetMarkerSize(2);
+	avg_calibrationgraph[ii]->SetLineColor(result.calibs+1);
+	avg_calibrationgraph[ii]->SetLineWidth(2);
+	avg_calibrationgraph[ii]->SetLineStyle(1);
+	if (headless == 1)
+	{
+		avg_calibrationgraph[ii]->Write();
+		return;
+	}
+
+	// the canvas is only painted once all graphs are on it
+	c_cali[ii]->cd();
+	avg_calibrationgraph[ii]->Draw("P");
+	l_cali[ii]->AddEntry(avg_calibrationgraph[ii],"Average","lp");
+	l_cali[ii]->Draw();
+	closecanvas(c_cali[ii]);
+
+}
+
+
+// ********************
+// this function plots the temperatures and fits the gradients of a measurement
+// ********************
+
+void plotanalysis(int ii)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	bookanalysisplot(ii);
+
+	// the gradient points continue the alternating shift of the calibration points
+	int pointsep = (result.calibs % 2 == 0) ? -1 : 1;
+
+	// the average temperature difference
+	float avg_tempdiff = 0.0;
+
+	// the temperature gradient between both aluminium blocks
+	float gradient_blocks = 0.0;
+
+	// plot the output
+	int tempcounter = 0;
+
+	// the temperatures
+	if (headless == 0)
+	{
+		c_temps[ii]->cd();
+		h_temps[ii]->Draw("");
+	}
+	for (int j=0;j<sensors;j++)
+	{
+
+		// skip 0 //FIXME
+		if (j != 0)
+		{
+			for (size_t k=0;k<result.graphtime[j].size();k++)
+			{
+				tempgraph[ii][j]->SetPoint(k, result.graphtime[j][k], result.graphtemperature[j][k]);
+			}
+			tempgraph[ii][j]->SetMarkerStyle(34);
+			tempgraph[ii][j]->SetMarkerColor(tempcounter+1);
+			tempgraph[ii][j]->SetMarkerSize(2);
+			tempgraph[ii][j]->SetLineColor(tempcounter+1);
+			tempgraph[ii][j]->SetLineWidth(2);
+			tempgraph[ii][j]->SetLineStyle(1);
+			tempcounter++;
+			if (headless == 1)
+			{
+				tempgraph[ii][j]->Write();
+				continue;
+			}
+			c_temps[ii]->cd();
+			tempgraph[ii][j]->Draw("L");
+			char tempchar[100];
+			sprintf(tempchar, "Sensor %i", j);
+			l_temps[ii]->AddEntry(tempgraph[ii][j],tempchar,"lp");
+		}
+	}
+	tempcounter = 0;
+
+	// draw the lines of the calibration times
+	for (int j=0;j<result.calibs && headless == 0;j++)
+	{
+		c_temps[ii]->cd();
+		caliposition[ii][j]->SetLineWidth(1);
+		caliposition[ii][j]->SetLineColor(2);
+		caliposition[ii][j]->SetLineStyle(6);
+		caliposition[ii][j]->SetX1(result.calitime[j]);
+		caliposition[ii][j]->SetX2(result.calitime[j]);
+		caliposition[ii][j]->SetY1(-10);
+		caliposition[ii][j]->SetY2(50);
+		caliposition[ii][j]->Draw();
+	}
+
+	// draw the lines of the gradient times
+	for (int j=0;j<result.stablepoints && headless == 0;j++)
+	{
+		c_temps[ii]->cd();
+		gradposition[ii][j]->SetLineWidth(1);
+		gradposition[ii][j]->SetLineColor(1);
+		gradposition[ii][j]->SetLineStyle(5);
+		gradposition[ii][j]->SetX1(result.stabletime[j]);
+		gradposition[ii][j]->SetX2(result.stabletime[j]);
+		gradposition[ii][j]->SetY1(-10);
+		gradposition[ii][j]->SetY2(50);
+		gradposition[ii][j]->Draw();
+	}
+
+	// the canvas is only painted once all graphs are on it
+	if (headless == 0)
+	{
+		c_temps[ii]->cd();
+		l_temps[ii]->Draw();
+		closecanvas(c_temps[ii]);
+	}
+
+	// the delta temperatures
+	if (headless == 0)
+	{
+		c_deltatemps[ii]->cd();
+		h_deltatemps[ii]->Draw("");
+	}
+	for (int j=0;j<sensors;j++)
+	{
+		// skip 0 and 4
+		// also 1 and 5
+		if (j != 0 && j != 4 && j != 1 && j != 5)
+		{
+			for (size_t k=0;k<result.deltagraphtime[j].size();k++)
+			{
+				deltatempgraph[ii][j]->SetPoint(k, result.deltagraphtime[j][k], result.graphdeltaDT[j][k]);
+			}
+			deltatempgraph[ii][j]->SetMarkerStyle(34);
+			deltatempgraph[ii][j]->SetMarkerColor(tempcounter+1);
+			deltatempgraph[ii][j]->SetMarkerSize(2);
+			deltatempgraph[ii][j]->SetLineColor(tempcounter+1);
+			deltatempgraph[ii][j]->SetLineWidth(2);
+			deltatempgraph[ii][j]->SetLineStyle(1);
+			tempcounter++;
+			if (headless == 1)
+			{
+				deltatempgraph[ii][j]->Write();
+				continue;
+			}
+			c_deltatemps[ii]->cd();
+			deltatempgraph[ii][j]->Draw("L");
+			char tempchar[100];
+			sprintf(tempchar, "Sensor %i - Sensor %i", j, j-1);
+			l_deltatemps[ii]->AddEntry(deltatempgraph[ii][j],tempchar,"lp");
+		}
+	}
+	tempcounter = 0;
+
+	// draw the lines of the gradient times
+	for (int j=0;j<result.stablepoints && headless == 0;j++)
+	{
+		c_deltatemps[ii]->cd();
+		gradposition[ii][j]->SetLineWidth(1);
+		gradposition[ii][j]->SetLineColor(1);
+		gradposition[ii][j]->SetLineStyle(5);
+		gradposition[ii][j]->SetX1(result.stabletime[j]);
+		gradposition[ii][j]->SetX2(result.stabletime[j]);
+		gradposition[ii][j]->SetY1(-10);
+		gradposition[ii][j]->SetY2(10);
+		gradposition[ii][j]->Draw();
+	}
+
+	if (headless == 0)
+	{
+		c_deltatemps[ii]->cd();
+		l_deltatemps[ii]->Draw();
+		closecanvas(c_deltatemps[ii]);
+	}
+
+	// the temperature gradients
+	if (headless == 0)
+	{
+		c_gradtemps[ii]->cd();
+		h_gradtemps[ii]->Draw();
+	}
+	const int n = 8;
+	for (int j=0;j<result.stablepoints;j++)
+	{
+		const double* x = sensorposition;
+		Double_t y[n] = {result.stabletemp[1][j],result.stabletemp[2][j],result.stabletemp[3][j],result.stabletemp[4][j],result.stabletemp[5][j],result.stabletemp[6][j],result.stabletemp[7][j],result.stabletemp[8][j]};
+		for (int k=0;k<8;k++)
+		{
+
+			if (debug<2)
+			{
+				cout << "Adding point " << k << " of stable point " << j << " at " << x[k] << " mm, " << y[k] << " K!" << endl;
+			}
+			gradgraph[ii][j]->SetPoint(k,x[k]-((j/2 + 1)*0.5*pointsep),y[k]);
+			gradgraph[ii][j]->SetPointError(k,positionerror,y[k]*errorpercentage);
+
+		}
+		pointsep = pointsep * (-1);
+		gradgraph[ii][j]->SetMarkerStyle(34);
+		gradgraph[ii][j]->SetMarkerColor(j+1);
+		gradgraph[ii][j]->SetMarkerSize(2);
+		gradgraph[ii][j]->SetLineColor(j+1);
+		gradgraph[ii][j]->SetLineWidth(2);
+		gradgraph[ii][j]->SetLineStyle(1);
+		if (headless == 0)
+		{
+			c_gradtemps[ii]->cd();
+			gradgraph[ii][j]->Draw("P");
+			char tempchar[100];
+			sprintf(tempchar, "Measurement point %i", j);
+			l_gradtemps[ii]->AddEntry(gradgraph[ii][j],tempchar,"lp");
+		}
+		
+		// check if there is a bad sensor and remove it from the gradient plot, from the bottom so the point numbers stay valid
+		// the graph has the positions 1 to 8
+		for (int k=sensors-2;k>0;k--)
+		{
+			if (brokenmask.at(ii) & (1u << k))
+			{
+				if (debug<3)
+				{
+					cout << "Found broken sensor " << sortorder.at(ii).at(k) << " removing point " << k << endl;
+				}
+				gradgraph[ii][j]->RemovePoint(k-1);
+			}
+		}
+
+		// show the fits
+		gradfit1[ii][j]->SetParameters(result.fitlow.offset[j], result.fitlow.slope[j]);
+		gradfit1[ii][j]->SetParError(0, sqrt(result.fitlow.covoffset[j]));
+		gradfit1[ii][j]->SetParError(1, sqrt(result.fitlow.covslope[j]));
+		gradfit1[ii][j]->SetChisquare(result.fitlow.chi2[j]);
+		gradfit1[ii][j]->SetNDF(result.fitlow.ndf[j]);
+		gradfit2[ii][j]->SetParameters(result.fithigh.offset[j], result.fithigh.slope[j]);
+		gradfit2[ii][j]->SetParError(0, sqrt(result.fithigh.covoffset[j]));
+		gradfit2[ii][j]->SetParError(1, sqrt(result.fithigh.covslope[j]));
+		gradfit2[ii][j]->SetChisquare(result.fithigh.chi2[j]);
+		gradfit2[ii][j]->SetNDF(result.fithigh.ndf[j]);
+		if (headless == 1)
+		{
+			gradgraph[ii][j]->Write();
+			gradfit1[ii][j]->Write();
+			gradfit2[ii][j]->Write();
+		} else {
+			gradfit1[ii][j]->Draw("l same");
+			gradfit2[ii][j]->Draw("l same");
+		}
+
+		avg_tempdiff += result.tempdiff[j];
+		h_blockdifference[ii]->Fill(result.tempdiff[j]);
+
+		if (debug<4)
+		{
+			cout << "Point " << j << ":" << endl;
+			cout << "Temperature difference between blocks is " << result.tempdiff[j] << " K." << endl;
+		}
+
+		// the gradient between the aluminium blocks
+		gradient_blocks += result.fitlow.slope[j];
+		gradient_blocks += result.fithigh.slope[j];
+
+		// calculate lambda of the blocks
+		float lambda_al = resistor * result.stablecurrent[j] * result.stablecurrent[j] / (( (result.fitlow.slope[j] + result.fithigh.slope[j]) / 2.0*1000.0) * area );
+		if (debug<4)
+		{
+			cout << "Alu Lambda is " << lambda_al << " W/(mK) at T = " << result.stablework[j] << " °C." <<  endl;
+		}
+		
+		if (debug<4)
+		{
+			cout << "Thermal resistance is " << result.tempdiff[j]/(resistor * result.stablecurrent[j] * result.stablecurrent[j]) << " K/W." <<  endl;
+			cout << " " << endl;
+		}
+
+	}
+	// calculate average temperature difference
+	if (result.stablepoints > 0)
+	{
+		avg_tempdiff /= result.stablepoints;
+		if (debug<4)
+		{
+			cout << " " << endl;
+			cout << "Average temperature difference between blocks is " << avg_tempdiff << " K!" << endl;
+		}
+
+		// the average gradient in aluminium, 2* since there are 2 fits...
+		gradient_blocks /= (2*result.stablepoints);
+		if (debug<4)
+		{
+			cout << "Average temperature gradient between blocks is " << gradient_blocks*1000.0 << " K/m." << endl;
+			cout << " " << endl;
+		}
+	} else {
+		if (debug<5)
+		{
+			cout << "No stable gradient points found!" << endl;
+			cout << " " << endl;
+		}
+	}
+
+	if (headless == 0)
+	{
+		c_gradtemps[ii]->cd();
+		l_gradtemps[ii]->Draw();
+		closecanvas(c_gradtemps[ii]);
+	}
+	h_blockdifference[ii]->Write();
+
+}
+
+
+// ********************
+// this function fits the sensors of both blocks at every stable point of a run again with TGraphErrors and minuit
+// the closed-form fits have to give the same slopes and offsets within fittolerance of their errors
+// ********************
+
+void checkfits(int ii)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	double worst = 0.0;
+	for (int block=0;block<2;block++)
+	{
+		const linefits& fits = (block == 0) ? result.fitlow : result.fithigh;
+		double xmin = (block == 0) ? 0.0 : 39.9;
+		double xmax = (block == 0) ? 40.1 : 80.0;
+		for (int j=0;j<result.stablepoints;j++)
+		{
+			TGraphErrors graph;
+			for (int k=1;k<=8;k++)
+			{
+				if (!(brokenmask.at(ii) & (1u << k)))
+				{
+					int p = graph.GetN();
+					graph.SetPoint(p, sensorposition[k-1], result.stabletemp[k][j]);
+					graph.SetPointError(p, positionerror, result.stabletemp[k][j]*errorpercentage);
+				}
+			}
+
+			// minuit, not the linear fitter, so the position errors are used
+			TF1 line("checkline", "pol1", xmin, xmax);
+			graph.Fit(&line, "RQNF");
+			double slopedeviation = fabs(line.GetParameter(1) - fits.slope[j]) / line.GetParError(1);
+			double offsetdeviation = fabs(line.GetParameter(0) - fits.offset[j]) / line.GetParError(0);
+			worst = std::max(worst, std::max(slopedeviation, offsetdeviation));
+		}
+	}
+
+	if (debug<5)
+	{
+		cout << "The fits of run " << ii << " agree with TGraphErrors within " << worst << " of their errors!" << endl;
+		cout << " " << endl;
+	}
+	if (!(worst <= fittolerance))
+	{
+		cout << "Error: the fits of run " << ii << " differ from TGraphErrors by " << worst << " of their errors, more than " << fittolerance << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+
+}
+
+
+// ********************
+// this function prints the output of a measurement and keeps its counters, runs are written in runlist order
+// ********************
+
+void writerun(int ii, runstate& state)
+{
+
+	// first the console output collected while looping the tuple
+	cout << state.messages.str();
+	state.messages.str("");
+
+	// the counters of this run, a stored run read nothing
+	runprofile& profile = profiles.at(ii);
+	if (!profile.stored)
+	{
+		profile.entries = state.tupleentrycount;
+		profile.usedentries = state.usedpoints;
+		profile.bytesread = state.bytesread;
+		profile.bytesunzipped = state.bytesunzipped;
+		profile.gaps = state.clock.gaps;
+		profile.duplicates = state.clock.duplicates;
+	}
+	profile.stablepoints = results[ii].stablepoints;
+
+	// minuit is not thread-safe, so the check runs here in the main thread
+	if (fitcheck == 1 && !results[ii].aborted)
+	{
+		checkfits(ii);
+	}
+
+}
+
+
+// ********************
+// this function keeps and prints the bytes the plots of a measurement take in the output, only the main process writes there
+// ********************
+
+void reportoutput(int ii, long long bytes)
+{
+	profiles.at(ii).outputbytes += bytes;
+	if (debug<4)
+	{
+		cout << "Wrote " << bytes << " bytes of plots for run " << ii << " into " << outputFile->GetName() << " !" << endl;
+	}
+}
+
+
+// ********************
+// this function plots the results of a measurement into the output file, it only needs the results
+// ********************
+
+void plotrun(int ii)
+{
+
+	// prepare output
+	outputFile->cd();
+	char namechar[100];
+	sprintf(namechar, "Measurement %i", ii);
+	TDirectory* thisdirectory = outputFile->mkdir(namechar);
+	thisdirectory->cd();
+
+	// the plots are made in the main thread
+	runprofile& profile = profiles.at(ii);
+	long int booked = bookedobjects;
+	int worker = profile.worker;
+	profile.worker = 0;
+	double starttime = walltime();
+
+	// nothing to show for a bad measurement
+	if (!results[ii].aborted)
+	{
+
+		// mode selection, 1 = calibration, 3 = calibration and analysis
+		if (mode == 1 || mode == 3)
+		{
+			plotcalibration(ii);
+		}
+
+		// mode selection, 2 = analysis, 3 = calibration and analysis
+		if (mode == 2 || mode == 3)
+		{
+			plotanalysis(ii);
+		}
+
+	}
+
+	stagedone(profile, stageplotting, starttime);
+	profile.worker = worker;
+	profile.objects += bookedobjects - booked;
+
+}
+
+
+// ********************
+// this function makes the plots of all runs once all results are known, spread over several processes if requested
+// each process plots every n-th run into its own file, the plots are then copied into the output in runlist order
+// ********************
+
+void renderplots()
+{
+
+	std::vector<int> runs;
+	for (unsigned int ii=0;ii<filelist.size();ii++)
+	{
+		if (runplotted(ii))
+		{
+			runs.push_back(ii);
+		}
+	}
+
+	if (exportformats != "")
+	{
+		gSystem->mkdir(exportdir.c_str(), kTRUE);
+	}
+
+	int nprocesses = std::min(renderprocesses, (int)runs.size());
+	if (nprocesses <= 1)
+	{
+		for (size_t r=0;r<runs.size();r++)
+		{
+			long long written = outputFile->GetBytesWritten();
+			plotrun(runs.at(r));
+			reportoutput(runs.at(r), outputFile->GetBytesWritten() - written);
+		}
+		return;
+	}
+
+	if (debug<5)
+	{
+		cout << " " << endl;
+		cout << "********************" << endl;
+		cout << "Plotting " << runs.size() << " runs in " << nprocesses << " processes!" << endl;
+		cout << "********************" << endl;
+		cout << " " << endl;
+	}
+
+	// the files of the processes
+	double starttime = walltime();
+	std::string basename = outputname;
+	if (basename.size() > 5 && basename.substr(basename.size()-5) == ".root")
+	{
+		basename = basename.substr(0, basename.size()-5);
+	}
+	std::vector<std::string> partnames;
+	for (int p=0;p<nprocesses;p++)
+	{
+		char tempchar[100];
+		sprintf(tempchar, "_plots%i.root", p);
+		partnames.push_back(basename + tempchar);
+	}
+
+	// each process has a copy of all results, it writes only into its own file and leaves without cleaning up the output
+	cout << flush;
+	std::vector<pid_t> children;
+	for (int p=0;p<nprocesses;p++)
+	{
+		pid_t pid = fork();
+		if (pid < 0)
+		{
+			cout << "Error starting a plotting process!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		if (pid == 0)
+		{
+			TFile* partfile = new TFile(partnames.at(p).c_str(), "RECREATE");
+			if (compression >= 0)
+			{
+				partfile->SetCompressionSettings(compression);
+			}
+			outputFile = partfile;
+			for (size_t r=p;r<runs.size();r+=nprocesses)
+			{
+				plotrun(runs.at(r));
+			}
+			partfile->Close();
+			cout << flush;
+			_exit(0);
+		}
+		children.push_back(pid);
+	}
+	for (size_t p=0;p<children.size();p++)
+	{
+		int status = 0;
+		waitpid(children.at(p), &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		{
+			cout << "Error: plotting process " << p << " failed!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+	}
+
+	// copy the plots into the output, in runlist order
+	std::vector<TFile*> partfiles;
+	for (int p=0;p<nprocesses;p++)
+	{
+		partfiles.push_back(new TFile(partnames.at(p).c_str(), "READ"));
+	}
+	for (size_t r=0;r<runs.size();r++)
+	{
+		char namechar[100];
+		sprintf(namechar, "Measurement %i", runs.at(r));
+		TDirectory* partdirectory = partfiles.at(r % nprocesses)->GetDirectory(namechar);
+		long long written = outputFile->GetBytesWritten();
+		outputFile->cd();
+		TDirectory* thisdirectory = outputFile->mkdir(namechar);
+		if (partdirectory == 0)
+		{
+			continue;
+		}
+		TIter next(partdirectory->GetListOfKeys());
+		TKey* key = 0;
+		while ((key = (TKey*)next()))
+		{
+			TObject* object = key->ReadObj();
+			thisdirectory->cd();
+			object->Write(key->GetName());
+			delete object;
+		}
+		reportoutput(runs.at(r), outputFile->GetBytesWritten() - written);
+	}
+	for (int p=0;p<nprocesses;p++)
+	{
+		partfiles.at(p)->Close();
+		delete partfiles.at(p);
+		gSystem->Unlink(partnames.at(p).c_str());
+	}
+	outputFile->cd();
+
+	stagedone(campaignprofile, stageplotting, starttime);
+
+}
+
+
+// ********************
+// the stored results of the runs
+// ********************
+
+// the layout of the stored results, to be increased whenever runresult or the way it is computed changes
+const int resultversion = 3;
+
+
+// ********************
+// this function returns everything the results of a run depend on: its runlist fields, its tuple and the analysis settings
+// material, thickness and comment only enter the comparison, so they are left out
+// ********************
+
+std::string resultkey(int ii)
+{
+
+	struct stat tuplestat;
+	long long filesize = -1;
+	long long mtime = -1;
+	if (stat(filelist.at(ii).c_str(), &tuplestat) == 0)
+	{
+		filesize = tuplestat.st_size;
+		mtime = tuplestat.st_mtime;
+	}
+
+	std::ostringstream key;
+	key.precision(17);
+	key << "version " << resultversion << endl;
+	key << "file " << filelist.at(ii) << " size " << filesize << " mtime " << mtime << endl;
+	key << "sorting";
+	for (size_t k=0;k<sortorder.at(ii).size();k++)
+	{
+		key << " " << sortorder.at(ii).at(k);
+	}
+	key << " broken " << brokenmask.at(ii) << endl;
+	key << "mode " << mode << " precision " << precision << " window " << stablewindow << " backend " << backend << " plotpoints " << plotpoints << " series " << seriesmode << endl;
+	key << "deltacali " << deltacali << " deltagrad " << deltagrad << " calibrationgap " << calibrationgap << " gradientgap " << gradientgap << endl;
+	key << "greasetemp " << greasetemp << " errorpercentage " << errorpercentage << " positionerror " << positionerror << " resistor " << resistor << " area " << area << endl;
+	key << "positions";
+	for (int k=0;k<8;k++)
+	{
+		key << " " << sensorposition[k];
+	}
+	key << endl;
+	return key.str();
+
+}
+
+
+// ********************
+// this function returns the file holding the stored results of a run
+// ********************
+
+std::string resultname(const std::string& key)
+{
+	std::ostringstream name;
+	name << storedir << "/" << std::hex << std::hash<std::string>()(key) << ".thermoresult";
+	return name.str();
+}
+
+
+// ********************
+// functions to write and read the values of a result
+// ********************
+
+template <class T> void writevalue(std::ofstream& out, const T& value)
+{
+	out.write((const char*)&value, sizeof(T));
+}
+
+template <class T> void writevalues(std::ofstream& out, const std::vector<T>& values)
+{
+	long long n = values.size();
+	writevalue(out, n);
+	if (n > 0)
+	{
+		out.write((const char*)&values[0], n*sizeof(T));
+	}
+}
+
+template <class T> void readvalue(std::ifstream& in, T& value)
+{
+	in.read((char*)&value, sizeof(T));
+}
+
+template <class T> void readvalues(std::ifstream& in, std::vector<T>& values)
+{
+	long long n = 0;
+	readvalue(in, n);
+	if (!in || n < 0 || n > (1LL << 32))
+	{
+		in.setstate(std::ios::failbit);
+		return;
+	}
+	values.resize(n);
+	if (n > 0)
+	{
+		in.read((char*)&values[0], n*sizeof(T));
+	}
+}
+
+
+// ********************
+// this function writes the results of a run into a stream
+// ********************
+
+void writeresult(std::ofstream& out, const runresult& result)
+{
+
+	writevalue(out, result.calibs);
+	writevalues(out, result.work_Temperature);
+	writevalues(out, result.calitime);
+	for (int j=0;j<sensors;j++)
+	{
+		writevalues(out, result.calitemp[j]);
+		writevalue(out, result.avg_calitemp[j]);
+		writevalue(out, result.avg_calierror[j]);
+	}
+	writevalue(out, result.aborted);
+	writevalue(out, result.stablepoints);
+	for (int j=0;j<sensors;j++)
+	{
+		writevalues(out, result.stabletemp[j]);
+	}
+	writevalues(out, result.stablework);
+	writevalues(out, result.stablecurrent);
+	writevalues(out, result.stabletime);
+	writevalues(out, result.tempdiff);
+	writevalues(out, result.tempdifftemp);
+	const linefits* fits[2] = {&result.fitlow, &result.fithigh};
+	for (int f=0;f<2;f++)
+	{
+		writevalues(out, fits[f]->offset);
+		writevalues(out, fits[f]->slope);
+		writevalues(out, fits[f]->covoffset);
+		writevalues(out, fits[f]->covmixed);
+		writevalues(out, fits[f]->covslope);
+		writevalues(out, fits[f]->chi2);
+		writevalues(out, fits[f]->ndf);
+	}
+	writevalues(out, result.plateaustart);
+	writevalues(out, result.plateauend);
+	for (int j=0;j<sensors;j++)
+	{
+		writevalues(out, result.graphtime[j]);
+		writevalues(out, result.graphtemperature[j]);
+		writevalues(out, result.deltagraphtime[j]);
+		writevalues(out, result.graphdeltaDT[j]);
+	}
+
+}
+
+
+// ********************
+// this function reads the results of a run from a stream
+// ********************
+
+void readresult(std::ifstream& in, runresult& result)
+{
+
+	readvalue(in, result.calibs);
+	readvalues(in, result.work_Temperature);
+	readvalues(in, result.calitime);
+	for (int j=0;j<sensors;j++)
+	{
+		readvalues(in, result.calitemp[j]);
+		readvalue(in, result.avg_calitemp[j]);
+		readvalue(in, result.avg_calierror[j]);
+	}
+	readvalue(in, result.aborted);
+	readvalue(in, result.stablepoints);
+	for (int j=0;j<sensors;j++)
+	{
+		readvalues(in, result.stabletemp[j]);
+	}
+	readvalues(in, result.stablework);
+	readvalues(in, result.stablecurrent);
+	readvalues(in, result.stabletime);
+	readvalues(in, result.tempdiff);
+	readvalues(in, result.tempdifftemp);
+	linefits* fits[2] = {&result.fitlow, &result.fithigh};
+	for (int f=0;f<2;f++)
+	{
+		readvalues(in, fits[f]->offset);
+		readvalues(in, fits[f]->slope);
+		readvalues(in, fits[f]->covoffset);
+		readvalues(in, fits[f]->covmixed);
+		readvalues(in, fits[f]->covslope);
+		readvalues(in, fits[f]->chi2);
+		readvalues(in, fits[f]->ndf);
+	}
+	readvalues(in, result.plateaustart);
+	readvalues(in, result.plateauend);
+	for (int j=0;j<sensors;j++)
+	{
+		readvalues(in, result.graphtime[j]);
+		readvalues(in, result.graphtemperature[j]);
+		readvalues(in, result.deltagraphtime[j]);
+		readvalues(in, result.graphdeltaDT[j]);
+	}
+
+}
+
+
+// ********************
+// this function writes the results of a run into its file
+// ********************
+
+void saveresult(int ii)
+{
+
+	std::string key = resultkey(ii);
+	std::string name = resultname(key);
+
+	// write next to the file and move it there when done, so nobody reads a half written result
+	char tempchar[100];
+	sprintf(tempchar, ".%i.%i.tmp", (int)getpid(), ii);
+	std::string tempname = name + tempchar;
+	std::ofstream out(tempname.c_str(), std::ios::binary | std::ios::trunc);
+
+	out.write("THERMOR", 8);
+	writevalue(out, resultversion);
+	writevalues(out, std::vector<char>(key.begin(), key.end()));
+	writeresult(out, results[ii]);
+
+	out.close();
+	if (!out || rename(tempname.c_str(), name.c_str()) != 0)
+	{
+		unlink(tempname.c_str());
+		cout << "Error writing the stored results " << name << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+
+}
+
+
+// ********************
+// this function reads the stored results of a run, if there are any for the same runlist fields, tuple and settings
+// ********************
+
+bool loadresult(int ii)
+{
+
+	std::string key = resultkey(ii);
+	std::ifstream in(resultname(key).c_str(), std::ios::binary);
+	if (!in.is_open())
+	{
+		return false;
+	}
+
+	char magic[8];
+	int version = 0;
+	std::vector<char> storedkey;
+	in.read(magic, 8);
+	readvalue(in, version);
+	readvalues(in, storedkey);
+	if (!in || memcmp(magic, "THERMOR", 8) != 0 || version != resultversion || std::string(storedkey.begin(), storedkey.end()) != key)
+	{
+		return false;
+	}
+
+	runresult result;
+	readresult(in, result);
+
+	// a broken file is analysed again
+	if (!in)
+	{
+		return false;
+	}
+
+	results[ii] = result;
+	return true;
+
+}
+
+
+// ********************
+// this function writes the results of all runs of this shard into the results file next to its output
+// ********************
+
+void saveshard(std::string name)
+{
+
+	std::ofstream out(name.c_str(), std::ios::binary | std::ios::trunc);
+	out.write("THERMOS", 8);
+	writevalue(out, resultversion);
+	int runs = 0;
+	for (unsigned int ii=0;ii<filelist.size();ii++)
+	{
+		runs += runselected(ii);
+	}
+	writevalue(out, runs);
+	for (unsigned int ii=0;ii<filelist.size();ii++)
+	{
+		if (runselected(ii))
+		{
+			writevalue(out, ii);
+			writevalues(out, std::vector<char>(filelist.at(ii).begin(), filelist.at(ii).end()));
+			writeresult(out, results[ii]);
+		}
+	}
+	out.close();
+	if (!out)
+	{
+		cout << "Error writing the results file " << name << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+
+	if (debug<5)
+	{
+		cout << "Wrote the results of " << runs << " runs into " << name << " !" << endl;
+		cout << " " << endl;
+	}
+
+}
+
+
+// ********************
+// this function reads the results files of all shards, every run of the runlist has to be in one of them
+// ********************
+
+void mergeshards()
+{
+
+	results.resize(filelist.size());
+	std::vector<int> found(filelist.size(), 0);
+	for (size_t f=0;f<mergelist.size();f++)
+	{
+		std::ifstream in(mergelist.at(f).c_str(), std::ios::binary);
+		char magic[8];
+		int version = 0;
+		int runs = 0;
+		in.read(magic, 8);
+		readvalue(in, version);
+		readvalue(in, runs);
+		if (!in || memcmp(magic, "THERMOS", 8) != 0 || version != resultversion)
+		{
+			cout << "Error reading the results file " << mergelist.at(f) << " !" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		for (int k=0;k<runs;k++)
+		{
+			unsigned int ii = 0;
+			std::vector<char> path;
+			readvalue(in, ii);
+			readvalues(in, path);
+			if (!in || ii >= filelist.size() || std::string(path.begin(), path.end()) != filelist.at(ii))
+			{
+				cout << "Error: the results file " << mergelist.at(f) << " does not belong to this runlist!" << endl;
+				exit ( EXIT_FAILURE );
+			}
+			readresult(in, results[ii]);
+			found.at(ii)++;
+		}
+		if (!in)
+		{
+			cout << "Error reading the results file " << mergelist.at(f) << " !" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		if (debug<5)
+		{
+			cout << "Read the results of " << runs << " runs from " << mergelist.at(f) << " !" << endl;
+		}
+	}
+
+	for (unsigned int ii=0;ii<filelist.size();ii++)
+	{
+		if (found.at(ii) != 1)
+		{
+			cout << "Error: run " << ii << " is in " << found.at(ii) << " results files instead of one!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+	}
+	if (debug<5)
+	{
+		cout << " " << endl;
+	}
+
+}
+
+
+// ********************
+// this function stores the results of a freshly analysed run, if requested
+// ********************
+
+void storerun(int ii)
+{
+	if (storedir != "" && mode >= 1 && mode <= 3)
+	{
+		saveresult(ii);
+	}
+}
+
+
+// ********************
+// the replay of a recorded tuple, to test the online analysis
+// ********************
+
+// how far the copy is on disk: the entries after each save and the wall time of the save
+std::mutex replaymutex;
+std::vector<long long> replayentries;
+std::vector<double> replaywalltime;
+std::atomic<int> replaydone(0);
+
+
+// ********************
+// a function to return the entries of the copy that are on disk
+// ********************
+
+long long replayed()
+{
+	std::lock_guard<std::mutex> lock(replaymutex);
+	return replayentries.empty() ? 0 : replayentries.back();
+}
+
+
+// ********************
+// a function to return the time since an entry of the copy went to disk, -1 if it is not there yet
+// ********************
+
+double replaylatency(long long entry)
+{
+	std::lock_guard<std::mutex> lock(replaymutex);
+	std::vector<long long>::iterator saved = std::upper_bound(replayentries.begin(), replayentries.end(), entry);
+	if (saved == replayentries.end())
+	{
+		return -1.0;
+	}
+	return walltime() - replaywalltime.at(saved - replayentries.begin());
+}
+
+
+// ********************
+// this function copies a recorded tuple entry by entry into a new file, replayspeed times faster than it was taken
+// the copy is saved regularly, like the daq does, so it can be followed while it grows
+// ********************
+
+void replaytuple(std::string recorded, std::string copy)
+{
+
+	TFile* infile = TFile::Open(recorded.c_str());
+	if (infile == 0 || infile->IsZombie())
+	{
+		cout << "Error opening root file " << recorded << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	TTree* intuple = (TTree*)infile->Get("thermoDAQ");
+	if (intuple == 0)
+	{
+		cout << "Error reading the tuple of " << recorded << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	TLeaf* timeleaf = intuple->GetLeaf("uTime");
+
+	TFile* outfile = new TFile(copy.c_str(), "RECREATE");
+	TTree* outtuple = intuple->CloneTree(0);
+	outtuple->SetDirectory(outfile);
+
+	long long entries = intuple->GetEntries();
+	long long saved = 0;
+	double lastsave = walltime();
+	double start = walltime();
+	double firsttime = 0.0;
+	for (long long i=0;i<entries;i++)
+	{
+		intuple->GetEntry(i);
+		double thetime = timeleaf->GetValue();
+		if (i == 0)
+		{
+			firsttime = thetime;
+		}
+
+		// wait until this entry is due, with everything before it on disk
+		double due = start + (thetime - firsttime)/replayspeed;
+		if (due > walltime() && i > saved)
+		{
+			outtuple->AutoSave("SaveSelf");
+			std::lock_guard<std::mutex> lock(replaymutex);
+			replayentries.push_back(i);
+			replaywalltime.push_back(walltime());
+			saved = i;
+			lastsave = walltime();
+		}
+		if (due > walltime())
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double>(due - walltime()));
+		}
+
+		outtuple->Fill();
+
+		// save regularly while entries come in fast
+		if (walltime() - lastsave >= followinterval || i == entries-1)
+		{
+			outtuple->AutoSave("SaveSelf");
+			std::lock_guard<std::mutex> lock(replaymutex);
+			replayentries.push_back(i+1);
+			replaywalltime.push_back(walltime());
+			saved = i+1;
+			lastsave = walltime();
+		}
+	}
+
+	outfile->Close();
+	delete outfile;
+	infile->Close();
+	delete infile;
+	replaydone = 1;
+
+}
+
+
+// ********************
+// this function feeds one point of a followed run to the calibration search and, once there is a calibration, to the analysis
+// new calibrations and stable points are published right away
+// ********************
+
+void onlinestep(int ii, runstate& state, runstate& calstate, long int i)
+{
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	// the calibration search gets the point as it was read
+	calstate.uTime = state.uTime;
+	calstate.time1 = state.time1;
+	calstate.usedpoints = state.usedpoints;
+	for (int j=0;j<sensors;j++)
+	{
+		calstate.temperature[j] = state.temperature[j];
+		calstate.deltaT[j] = state.deltaT[j];
+	}
+	calstate.current1 = state.current1;
+	calstate.workingTemperature = state.workingTemperature;
+
+	// to make sure there is a gap in between the calibrations, count points between
+	calstate.inbetween++;
+
+	int calibs = result.calibs;
+	calibrationstep(ii, calstate, i);
+	if (result.calibs > calibs)
+	{
+		averagecalibration(ii, calstate);
+	}
+	cout << calstate.messages.str();
+	calstate.messages.str("");
+	if (result.calibs > calibs)
+	{
+		cout << "Calibration " << calibs << " at " << state.time1 << " s with working temperature " << result.work_Temperature[calibs] << " deg C!" << endl;
+	}
+
+	// the analysis starts with the first calibration
+	if (result.calibs > 0)
+	{
+		int points = result.stablepoints;
+		analysisstep(ii, state, i, false);
+		cout << state.messages.str();
+		state.messages.str("");
+		if (result.stablepoints > points)
+		{
+			fitgradients(ii);
+			float lambda = resistor * result.stablecurrent[points] * result.stablecurrent[points] / (( (result.fitlow.slope[points] + result.fithigh.slope[points]) / 2.0*1000.0) * area );
+			cout << "Stable point " << points << " at " << result.stabletime[points] << " s: temperature difference " << result.tempdiff[points] << " K at " << result.tempdifftemp[points] << " deg C, lambda " << lambda << " W/(mK)!" << endl;
+		}
+	}
+
+}
+
+
+// ********************
+// this function analyses a run while its tuple is still being written, until no new entries come in
+// ********************
+
+void followrun(int ii)
+{
+
+	results.resize(filelist.size());
+
+	// the results of this run
+	runresult& result = results[ii];
+
+	// the analysis and the calibration search each look at the points with their own state
+	runstate state, calstate;
+
+	// a recorded tuple is replayed into a copy, which is followed instead
+	std::thread replay;
+	if (replayspeed > 0.0)
+	{
+		std::string copy = outputname;
+		if (copy.size() > 5 && copy.substr(copy.size()-5) == ".root")
+		{
+			copy = copy.substr(0, copy.size()-5);
+		}
+		copy += "_replay.root";
+		if (debug<5)
+		{
+			cout << "Replaying " << filelist.at(ii) << " " << replayspeed << " times faster into " << copy << " !" << endl;
+		}
+		replay = std::thread(replaytuple, filelist.at(ii), copy);
+		while (replayed() == 0 && !replaydone)
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double>(followinterval));
+		}
+		filelist.at(ii) = copy;
+	}
+
+	openfile(ii, state);
+	cout << state.messages.str();
+	state.messages.str("");
+
+	// the time from an entry on disk to its calibration or stable point
+	std::vector<double> latency;
+
+	long int next = 0;
+	double lastentry = walltime();
+	while (true)
+	{
+
+		// look for new entries
+		state.mytuple->Refresh();
+		long int count = state.mytuple->GetEntries();
+		state.tupleentrycount = count;
+		if (iomode == 1 && count > next)
+		{
+			traincache(state);
+		}
+		scantimes(state, count);
+		for (long int i = next; i < count; i++)
+		{
+			// only every precision-th event, the stability detector sees every entry
+			bool sample = (i % precision == 0);
+			if (!sample && stablewindow <= 0.0)
+			{
+				continue;
+			}
+
+			readentry(state, i);
+
+			if (stablewindow > 0.0)
+			{
+				pushwindow(state.window, state.uTime, state.temperature);
+			}
+
+			if (sample)
+			{
+				// count points for graphs
+				state.usedpoints++;
+
+				// set the time
+				state.time1 = clocktime(state);
+
+				if (stablewindow > 0.0)
+				{
+					windowchange(state.window, state.deltaT);
+				}
+
+				int calibs = result.calibs;
+				int points = result.stablepoints;
+				onlinestep(ii, state, calstate, i);
+				if (replayspeed > 0.0 && (result.calibs > calibs || result.stablepoints > points))
+				{
+					latency.push_back(replaylatency(i));
+				}
+			}
+		}
+		if (count > next)
+		{
+			lastentry = walltime();
+		}
+		next = count;
+
+		// the run is over when the replay is through, or when the daq stopped writing
+		if (replayspeed > 0.0 ? (replaydone && next >= replayed()) : (walltime() - lastentry > followtimeout))
+		{
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::duration<double>(followinterval));
+
+	}
+	if (replay.joinable())
+	{
+		replay.join();
+	}
+
+	closefile(state);
+
+	if (!latency.empty() && debug<5)
+	{
+		double sum = 0.0;
+		double maximum = 0.0;
+		for (size_t k=0;k<latency.size();k++)
+		{
+			sum += latency.at(k);
+			maximum = std::max(maximum, latency.at(k));
+		}
+		state.messages << "Found " << latency.size() << " calibrations and stable points with a latency of " << sum/latency.size() << " s on average, " << maximum << " s at most!" << endl;
+		state.messages << " " << endl;
+	}
+	cout << state.messages.str();
+
+	// the points found online only knew the calibrations found up to then, so the finished run is analysed again
+	// as without --follow: only these results are plotted, stored, compared and written into the series
+	if (debug<5)
+	{
+		cout << "The run is over, analysing " << filelist.at(ii) << " again as a whole!" << endl;
+		cout << " " << endl;
+	}
+	results[ii] = runresult();
+	runstate offline;
+	processrun(ii, offline);
+	storerun(ii);
+	writerun(ii, offline);
+
+}
+
+
+// ********************
+// this function analyses all runs of the runlist, several runs at once if requested
+// ********************
+
+void runscheduler()
+{
+
+	// the results of each run
+	results.resize(filelist.size());
+
+	std::vector<runstate*> states;
+	for (unsigned int ii=0;ii<filelist.size();ii++)
+	{
+		states.push_back(new runstate());
+	}
+
+	// runs with stored results for the same runlist fields, tuple and settings are not analysed again
+	// a series needs every point of the run, so with --series all runs are analysed and only stored
+	std::vector<int> stored(filelist.size(), 0);
+	if (storedir != "" && mode >= 1 && mode <= 3 && seriesmode == 1 && debug<5)
+	{
+		cout << "Analysing all runs again for their series, the results are only stored!" << endl;
+		cout << " " << endl;
+	}
+	if (storedir != "" && mode >= 1 && mode <= 3 && seriesmode == 0)
+	{
+		int nstored = 0;
+		for (unsigned int ii=0;ii<filelist.size();ii++)
+		{
+			stored.at(ii) = runselected(ii) && loadresult(ii);
+			profiles.at(ii).stored = stored.at(ii);
+			nstored += stored.at(ii);
+			if (stored.at(ii) && debug<5)
+			{
+				states.at(ii)->messages << " " << endl;
+				states.at(ii)->messages << "Using the stored results of " << filelist.at(ii) << " !" << endl;
+				states.at(ii)->messages << " " << endl;
+			}
+		}
+		if (debug<5)
+		{
+			cout << "Found stored results for " << nstored << " of " << filelist.size() << " runs!" << endl;
+			cout << " " << endl;
+		}
+	}
+
+	// how many runs at once?
+	int nthreads = threadcount(filelist.size());
+
+	// rdataframe uses the threads inside each run
+	if (backend == 1)
+	{
+		nthreads = 1;
+	}
+
+	if (nthreads <= 1)
+	{
+
+		// serial: loop over each measurement in the runlist
+		for (unsigned int ii=0;ii<filelist.size();ii++)
+		{
+			if (runselected(ii))
+			{
+				if (!stored.at(ii))
+				{
+					processrun(ii, *states.at(ii));
+					storerun(ii);
+				}
+				writerun(ii, *states.at(ii));
+			}
+			delete states.at(ii);
+		}
+
+	} else {
+
+		if (debug<5)
+		{
+			cout << " " << endl;
+			cout << "********************" << endl;
+			cout << "Analysing " << filelist.size() << " runs with " << nthreads << " threads!" << endl;
+			cout << "********************" << endl;
+			cout << " " << endl;
+		}
+
+		// schedule the largest tuples first, so the long runs do not end up last
+		std::vector<long int> entries;
+		std::vector<int> order;
+		for (unsigned int ii=0;ii<filelist.size();ii++)
+		{
+			entries.push_back((stored.at(ii) || !runselected(ii)) ? 0 : countentries(filelist.at(ii)));
+			if (!stored.at(ii) && runselected(ii))
+			{
+				order.push_back(ii);
+			}
+		}
+		std::stable_sort(order.begin(), order.end(), [&entries](int a, int b) { return entries.at(a) > entries.at(b); });
+
+		// each worker takes the next run from the queue
+		parallelfor(order.size(), [&](int k, int worker)
+		{
+			profiles.at(order.at(k)).worker = worker + 1;
+			processrun(order.at(k), *states.at(order.at(k)));
+			storerun(order.at(k));
+		});
+
+		// the output is written serially in runlist order, identical to a serial run
+		for (unsigned int ii=0;ii<filelist.size();ii++)
+		{
+			if (runselected(ii))
+			{
+				writerun(ii, *states.at(ii));
+			}
+			delete states.at(ii);
+		}
+
+	}
+
+}
+
+
+// ********************
+// a calibration of a sensor for the overall comparison, filled once all materials are compared
+// ********************
+
+struct calibrationfill
+{
+	int sensor;
+	float temperature, calibration;
+
+	calibrationfill(int asensor, float atemperature, float acalibration) : sensor(asensor), temperature(atemperature), calibration(acalibration)
+	{
+	}
+};
+
+
+// ********************
+// this function compares the runs of one material: it fills the roots of this material only
+// the calibrations and the console output are kept for the caller, so materials can be compared in parallel
+// ********************
+
+void comparematerial(int l, const std::vector<std::vector<int> >& groups, std::vector<calibrationfill>& calibrations, std::ostringstream& messages)
+{
+
+	if (debug<1)
+	{
+		messages << "Looping all materials: " << materiallist.at(l) << endl;
+	}
+
+	// point counter for this graph
+	int g_blockcompmaterialcount = 0;
+	int g_gradcompmaterialcount = 0;
+
+	// loop thicknesses
+	for (int m=0;m<thicknesscount;m++)
+	{
+
+		if (debug<1)
+		{
+			messages << "Looping all thicknesses: " << thicknesslist.at(m) << endl;
+		}
+
+		// go through the measurements of this material and thickness, in runlist order
+		for (size_t r=0;r<groups.at(m).size();r++)
+		{
+
+			unsigned int ik = groups.at(m).at(r);
+
+			// the results of this run
+			runresult& result = results[ik];
+
+			if (debug<4)
+			{
+				messages << "Looping all calibrations!" << endl;
+				messages << " " << endl;
+			}
+
+			// go over the calibrations
+			for (int j=0;j<result.calibs;j++)
+			{
+				for (int k=0;k<sensors;k++)
+				{
+					calibrations.push_back(calibrationfill(k, result.work_Temperature[j], result.calitemp[k][j]-result.work_Temperature[j]));
+					// some more comparison?
+					if (debug<2)
+					{
+						messages << "Run: " << ik << ", calibration: " << j << " , sensor: " << k << " , calibration temperature: " << result.calitemp[k][j] << " , working temperature: "<< result.work_Temperature[j] << endl;
+					}
+				}
+			}
+
+			if (debug<2)
+			{
+				messages << " " << endl;
+			}
+
+			// go over the stable points
+			for (int j=0;j<result.stablepoints;j++)
+			{
+				// fill histograms
+				// the temperature difference
+				h_blockcompmaterial[l]->Fill( result.tempdiff[j]);
+
+				// the temperature difference at the measurement temp
+				h_blockcompmaterial_2D[l]->Fill(result.tempdifftemp[j] , result.tempdiff[j]);
+
+				// add the points to the graph of this material
+				g_blockcompmaterial[l]->SetPoint(g_blockcompmaterialcount,result.tempdifftemp[j],result.tempdiff[j]);
+
+				// vs slope
+
+				float slope1 = result.fitlow.slope[j];
+				float slope2 = result.fithigh.slope[j];
+				g_blockcompmaterial2[l]->SetPoint(g_blockcompmaterialcount,((slope1 + slope2)/2.0),result.tempdiff[j]);
+				g_blockcompmaterialcount++;
+
+				float lambda = resistor * result.stablecurrent[j] * result.stablecurrent[j] / area / ((slope1 + slope2)/2.0*1000.0);
+
+				if (debug<2)
+				{
+					messages << "Run: " << ik << ", stable point: " << j << ", lambda: " << lambda << endl;
+				}
+
+				g_gradcompmaterial[l]->SetPoint(g_gradcompmaterialcount,result.tempdifftemp[j],lambda);
+				
+				g_gradcompmaterialcount++;
+
+				if (debug<1)
+				{
+					messages << "Filling comparison output histos: Run " << ik << ", stable point " << j << endl;
+				}
+			}
+
+			if (debug<2)
+			{
+				messages << " " << endl;
+			}
+
+		} // done run loop
+	
+	} // done thickness loop int m
+
+}
+
+
+// ********************
+// this function compares the results of all runs: by material and thickness, and all calibrations
+// ********************
+
+void comparemeasurements()
+{
+
+	if (debug<5)
+	{
+		cout << " " << endl;
+		cout << "********************" << endl;
+		cout << "Preparing final analysis!" << endl;
+		cout << "********************" << endl;
+		cout << " " << endl;
+	}
+
+	// prepare output canvas
+	outputFile->cd();
+	if (headless == 0)
+	{
+		c_blockcompmaterial_g->cd();
+		h_blockcompmaterial_g->Draw();
+
+		c_blockcompmaterial_g2->cd();
+		h_blockcompmaterial_g2->Draw();
+
+		c_gradcompmaterial->cd();
+		h_gradcompmaterial->Draw();
+	}
+
+	// the runs of each material and thickness, in runlist order, sorted once instead of looking at every run for each of them
+	std::vector<std::vector<std::vector<int> > > groups(materialcount, std::vector<std::vector<int> >(thicknesscount));
+	for (unsigned int ik=0;ik<filelist.size();ik++)
+	{
+		groups.at(materialid.at(ik)).at(thicknessid.at(ik)).push_back(ik);
+	}
+
+	// the materials are compared in parallel, each only fills its own roots
+	std::vector<std::vector<calibrationfill> > calibrations(materialcount);
+	std::vector<std::ostringstream*> messages;
+	for (int l=0;l<materialcount;l++)
+	{
+		messages.push_back(new std::ostringstream());
+	}
+	parallelfor(materialcount, [&](int l, int)
+	{
+		comparematerial(l, groups.at(l), calibrations.at(l), *messages.at(l));
+	});
+
+	// loop the materials
+	for (int l=0;l<materialcount;l++)
+	{
+
+		// the output and the calibrations of each material in material order, as if they were compared one after the other
+		cout << messages.at(l)->str();
+		delete messages.at(l);
+		for (size_t k=0;k<calibrations.at(l).size();k++)
+		{
+			const calibrationfill& fill = calibrations.at(l).at(k);
+			h_calicomp[fill.sensor]->Fill(fill.temperature, fill.calibration);
+		}
+
+		// the comparisons between materials
+		outputFile->cd();
+		char tempchar[100];
+		sprintf(tempchar, "Comparison of Material %s", materiallist.at(l).c_str());
+		TDirectory* materialdirectory = outputFile->mkdir(tempchar);
+		materialdirectory->cd();
+		h_blockcompmaterial[l]->Write();
+		h_blockcompmaterial_2D[l]->Write();
+
+		g_blockcompmaterial[l]->SetMarkerStyle(34);
+		g_blockcompmaterial[l]->SetMarkerColor(l+1);
+		g_blockcompmaterial[l]->SetMarkerSize(2);
+		g_blockcompmaterial[l]->SetLineColor(l+1);
+		g_blockcompmaterial[l]->SetLineWidth(2);
+		g_blockcompmaterial[l]->SetLineStyle(1);
+		if (headless == 1)
+		{
+			g_blockcompmaterial[l]->Write();
+		} else {
+			outputFile->cd();
+			c_blockcompmaterial_g->cd();
+			g_blockcompmaterial[l]->Draw("P");
+			sprintf(tempchar, "Material %s", materiallist.at(l).c_str());
+			l_blockcompmaterial_g->AddEntry(g_blockcompmaterial[l],tempchar,"lp");
+		}
+
+		g_blockcompmaterial2[l]->SetMarkerStyle(34);
+		g_blockcompmaterial2[l]->SetMarkerColor(l+1);
+		g_blockcompmaterial2[l]->SetMarkerSize(2);
+		g_blockcompmaterial2[l]->SetLineColor(l+1);
+		g_blockcompmaterial2[l]->SetLineWidth(2);
+		g_blockcompmaterial2[l]->SetLineStyle(1);
+		if (headless == 1)
+		{
+			g_blockcompmaterial2[l]->Write();
+		} else {
+			outputFile->cd();
+			c_blockcompmaterial_g2->cd();
+			g_blockcompmaterial2[l]->Draw("P");
+			sprintf(tempchar, "Material %s", materiallist.at(l).c_str());
+			l_blockcompmaterial_g2->AddEntry(g_blockcompmaterial2[l],tempchar,"lp");
+		}
+
+		g_gradcompmaterial[l]->SetMarkerStyle(34);
+		g_gradcompmaterial[l]->SetMarkerColor(l+1);
+		g_gradcompmaterial[l]->SetMarkerSize(2);
+		g_gradcompmaterial[l]->SetLineColor(l+1);
+		g_gradcompmaterial[l]->SetLineWidth(2);
+		g_gradcompmaterial[l]->SetLineStyle(1);
+		if (headless == 1)
+		{
+			g_gradcompmaterial[l]->Write();
+		} else {
+			outputFile->cd();
+			c_gradcompmaterial->cd();
+			g_gradcompmaterial[l]->Draw("P");
+			sprintf(tempchar, "Material %s", materiallist.at(l).c_str());
+			l_gradcompmaterial->AddEntry(g_gradcompmaterial[l],tempchar,"lp");
+		}
+
+	} // done material loop int l
+
+	// the canvases are only painted once all materials are on them
+	if (headless == 0)
+	{
+		outputFile->cd();
+		c_blockcompmaterial_g->cd();
+		l_blockcompmaterial_g->Draw();
+		closecanvas(c_blockcompmaterial_g);
+
+		c_blockcompmaterial_g2->cd();
+		l_blockcompmaterial_g2->Draw();
+		closecanvas(c_blockcompmaterial_g2);
+
+		c_gradcompmaterial->cd();
+		l_gradcompmaterial->Draw();
+		closecanvas(c_gradcompmaterial);
+	}
+	
+	outputFile->cd();
+	TDirectory* calidirectory = outputFile->mkdir("Calibration Comparison");
+	calidirectory->cd();
+//	char tempchar[100];
+	for (int i=0;i<sensors;i++)
+	{
+		h_calicomp[i]->Write();
+	}
+	outputFile->cd();
+
+}
+
+
+// ********************
+// this function writes the stable points of all runs as a table, one line per point
+// ********************
+
+void writetable()
+{
+
+	std::ofstream out(tablename.c_str());
+	if (!out.is_open())
+	{
+		cout << "Error writing results table " << tablename << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+
+	out << "# run,file,material,thickness,point,time,workingtemperature,current,temperature,temperaturedifference,slopelow,slopelowerror,slopehigh,slopehigherror,lambda,resistance" << endl;
+	int lines = 0;
+	for (unsigned int ii=0;ii<results.size();ii++)
+	{
+		const runresult& result = results[ii];
+		if (result.aborted)
+		{
+			continue;
+		}
+		for (int j=0;j<result.stablepoints;j++)
+		{
+			float slope1 = result.fitlow.slope[j];
+			float slope2 = result.fithigh.slope[j];
+			float power = resistor * result.stablecurrent[j] * result.stablecurrent[j];
+			float lambda = power / area / ((slope1 + slope2)/2.0*1000.0);
+			out << ii << "," << filelist.at(ii) << "," << material.at(ii) << "," << thickness.at(ii) << "," << j;
+			out << "," << result.stabletime[j] << "," << result.stablework[j] << "," << result.stablecurrent[j];
+			out << "," << result.tempdifftemp[j] << "," << result.tempdiff[j];
+			out << "," << slope1 << "," << sqrt(result.fitlow.covslope[j]) << "," << slope2 << "," << sqrt(result.fithigh.covslope[j]);
+			out << "," << lambda << "," << result.tempdiff[j]/power << endl;
+			lines++;
+		}
+	}
+
+	if (debug<5)
+	{
+		cout << "Wrote " << lines << " stable points into the results table " << tablename << " !" << endl;
+	}
+
+}
+
+
+// ********************
+// a run found in the daq logs: the tuple and the description of its log
+// ********************
+
+struct discoveredrun
+{
+	std::string file;
+	std::string description;
+};
+
+// the runs found in a directory, with the stamp of the directory when it was searched
+struct discovereddirectory
+{
+	unsigned long long stamp;
+	std::vector<discoveredrun> runs;
+};
+
+
+// ********************
+// a function to return the modification time of a file or directory, -1 if it does not exist
+// ********************
+
+long int modificationtime(const std::string& name)
+{
+	struct stat info;
+	if (stat(name.c_str(), &info) != 0)
+	{
+		return -1;
+	}
+	return info.st_mtime;
+}
+
+
+// ********************
+// this function reads one directory: the directories right below it, in the same order on every file system,
+// and a stamp of the modification times of the directory and of its xml logs, so a log edited in place changes it
+// ********************
+
+bool readdirectory(const std::string& directory, std::vector<std::string>& below, unsigned long long& stamp)
+{
+	DIR* adir = opendir(directory.c_str());
+	if (adir == 0)
+	{
+		return false;
+	}
+	std::vector<std::string> logs;
+	struct dirent* entry = 0;
+	while ((entry = readdir(adir)) != 0)
+	{
+		std::string name = entry->d_name;
+		if (name == "." || name == "..")
+		{
+			continue;
+		}
+		std::string path = directory + "/" + name;
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+		{
+			continue;
+		}
+		if (S_ISDIR(info.st_mode))
+		{
+			if (std::find(excludelist.begin(), excludelist.end(), name) == excludelist.end())
+			{
+				below.push_back(path);
+			}
+		} else if (name.size() > 4 && name.substr(name.size()-4) == ".xml") {
+			std::ostringstream log;
+			log << name << " " << (long int)info.st_mtime << " " << (long long)info.st_size;
+			logs.push_back(log.str());
+		}
+	}
+	closedir(adir);
+	std::sort(below.begin(), below.end());
+	std::sort(logs.begin(), logs.end());
+
+	std::ostringstream key;
+	key << modificationtime(directory);
+	for (size_t i=0;i<logs.size();i++)
+	{
+		key << "," << logs.at(i);
+	}
+	stamp = std::hash<std::string>()(key.str());
+	return true;
+}
+
+
+// ********************
+// this function puts a directory of the walk and all directories below it into the list, in the order of a walk down each one
+// ********************
+
+void appenddirectories(const std::string& directory, const std::unordered_map<std::string, std::vector<std::string> >& tree, const std::unordered_map<std::string, unsigned long long>& stamps, std::vector<std::string>& directories, std::vector<unsigned long long>& directorystamps)
+{
+	std::unordered_map<std::string, std::vector<std::string> >::const_iterator node = tree.find(directory);
+	if (node == tree.end())
+	{
+		return;
+	}
+	directories.push_back(directory);
+	directorystamps.push_back(stamps.at(directory));
+	for (size_t i=0;i<node->second.size();i++)
+	{
+		appenddirectories(node->second.at(i), tree, stamps, directories, directorystamps);
+	}
+}
+
+
+// ********************
+// this function collects the given directories and all directories below them, with their stamps
+// the walk goes level by level, the directories of each level are read at once
+// ********************
+
+void listdirectories(const std::vector<std::string>& roots, std::vector<std::string>& directories, std::vector<unsigned long long>& directorystamps)
+{
+
+	// the directories right below each directory and its stamp
+	std::unordered_map<std::string, std::vector<std::string> > tree;
+	std::unordered_map<std::string, unsigned long long> stamps;
+
+	std::vector<std::string> level = roots;
+	while (!level.empty())
+	{
+		std::vector<std::vector<std::string> > below(level.size());
+		std::vector<unsigned long long> levelstamps(level.size(), 0);
+		std::vector<int> opened(level.size(), 0);
+		parallelfor(level.size(), [&](int i, int)
+		{
+			opened.at(i) = readdirectory(level.at(i), below.at(i), levelstamps.at(i));
+		});
+
+		std::vector<std::string> next;
+		for (size_t i=0;i<level.size();i++)
+		{
+			if (!opened.at(i))
+			{
+				if (debug<5)
+				{
+					cout << "Warning: can not open directory " << level.at(i) << " !" << endl;
+				}
+				continue;
+			}
+			tree[level.at(i)] = below.at(i);
+			stamps[level.at(i)] = levelstamps.at(i);
+			next.insert(next.end(), below.at(i).begin(), below.at(i).end());
+		}
+		level.swap(next);
+	}
+
+	for (size_t i=0;i<roots.size();i++)
+	{
+		appenddirectories(roots.at(i), tree, stamps, directories, directorystamps);
+	}
+
+}
+
+
+// ********************
+// this function reads the daq logs in a directory: each xml file with a "Log time" entry belongs to the tuple of the same name
+// ********************
+
+void searchdirectory(const std::string& directory, discovereddirectory& found)
+{
+	found.runs.clear();
+
+	DIR* adir = opendir(directory.c_str());
+	if (adir == 0)
+	{
+		return;
+	}
+	std::vector<std::string> logs;
+	struct dirent* entry = 0;
+	while ((entry = readdir(adir)) != 0)
+	{
+		std::string name = entry->d_name;
+		if (name.size() > 4 && name.substr(name.size()-4) == ".xml")
+		{
+			logs.push_back(name);
+		}
+	}
+	closedir(adir);
+	std::sort(logs.begin(), logs.end());
+
+	for (size_t i=0;i<logs.size();i++)
+	{
+		std::string path = directory + "/" + logs.at(i);
+		std::ifstream log(path.c_str());
+		std::string line;
+		while (std::getline(log, line))
+		{
+			// the description is the text of the first log entry
+			size_t pos = line.find("Log time");
+			if (pos == std::string::npos)
+			{
+				continue;
+			}
+			size_t open = line.find('>', pos);
+			size_t close = line.find('<', open);
+			if (open == std::string::npos || close == std::string::npos)
+			{
+				continue;
+			}
+			discoveredrun run;
+			run.file = path.substr(0, path.size()-4) + ".root";
+			run.description = line.substr(open + 1, close - open - 1);
+
+			// no line ends, the description ends the line of the runlist
+			std::replace(run.description.begin(), run.description.end(), '\r', ' ');
+			if (modificationtime(run.file) < 0)
+			{
+				if (debug<4)
+				{
+					cout << "Log " << path << " has no tuple " << run.file << " !" << endl;
+				}
+			} else {
+				found.runs.push_back(run);
+			}
+			break;
+		}
+	}
+}
+
+
+// ********************
+// this function finds the runs in the discovery directories and writes a runlist for them
+// directories that did not change since the last search are taken from the cache next to the runlist
+// ********************
+
+void discoverruns(const std::string& runlistname)
+{
+
+	if (debug<5)
+	{
+		cout << " " << endl;
+		cout << "********************" << endl;
+		cout << "Searching for runs!" << endl;
+		cout << "********************" << endl;
+		cout << " " << endl;
+	}
+
+	// all directories to search
+	std::vector<std::string> roots;
+	for (size_t i=0;i<discoverlist.size();i++)
+	{
+		std::string directory = discoverlist.at(i);
+		while (directory.size() > 1 && directory.at(directory.size()-1) == '/')
+		{
+			directory.erase(directory.size()-1);
+		}
+		roots.push_back(directory);
+	}
+	std::vector<std::string> directories;
+	std::vector<unsigned long long> stamps;
+	listdirectories(roots, directories, stamps);
+
+	// the cache: a line with the stamp and name of each directory, followed by the runs found in it
+	std::string cachename = runlistname + ".cache";
+	std::unordered_map<std::string, discovereddirectory> cache;
+	std::ifstream cachein(cachename.c_str());
+	std::string line;
+	discovereddirectory* current = 0;
+	while (std::getline(cachein, line))
+	{
+		if (line.size() > 2 && line.substr(0,2) == "D ")
+		{
+			size_t pos = line.find(' ', 2);
+			if (pos == std::string::npos)
+			{
+				current = 0;
+				continue;
+			}
+			current = &cache[line.substr(pos + 1)];
+			current->stamp = strtoull(line.substr(2, pos - 2).c_str(), 0, 10);
+		} else if (line.size() > 2 && line.substr(0,2) == "F " && current != 0) {
+			size_t pos = line.find(',');
+			discoveredrun run;
+			run.file = line.substr(2, pos - 2);
+			run.description = (pos == std::string::npos) ? "" : line.substr(pos + 1);
+			current->runs.push_back(run);
+		}
+	}
+	cachein.close();
+
+	// only the directories that changed are searched again
+	std::vector<discovereddirectory> found(directories.size());
+	std::vector<int> changed;
+	for (size_t i=0;i<directories.size();i++)
+	{
+		std::unordered_map<std::string, discovereddirectory>::iterator cached = cache.find(directories.at(i));
+		if (cached != cache.end() && cached->second.stamp == stamps.at(i))
+		{
+			found.at(i) = cached->second;
+		} else {
+			found.at(i).stamp = stamps.at(i);
+			changed.push_back(i);
+		}
+	}
+
+	// several directories at once
+	parallelfor(changed.size(), [&](int k, int)
+	{
+		searchdirectory(directories.at(changed.at(k)), found.at(changed.at(k)));
+	});
+
+	// the runlist, in the order of the directories
+	std::ofstream runlist(runlistname.c_str());
+	std::ofstream cacheout(cachename.c_str());
+	if (!runlist.is_open() || !cacheout.is_open())
+	{
+		cout << "Error writing runlist file " << runlistname << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	runlist << "# Runlist:" << endl;
+	int nruns = 0;
+	for (size_t i=0;i<directories.size();i++)
+	{
+		cacheout << "D " << found.at(i).stamp << " " << directories.at(i) << endl;
+		for (size_t k=0;k<found.at(i).runs.size();k++)
+		{
+			const discoveredrun& run = found.at(i).runs.at(k);
+			runlist << run.file << "," << discoversorting << "," << discoverbroken << "," << discoverthickness << "," << run.description << endl;
+			cacheout << "F " << run.file << "," << run.description << endl;
+			nruns++;
+		}
+	}
+
+	if (debug<5)
+	{
+		cout << "Found " << nruns << " runs in " << directories.size() << " directories, searched " << changed.size() << " of them!" << endl;
+		cout << "Wrote the runlist " << runlistname << " !" << endl;
+	}
+
+}
+
+
+// ********************
+// this function writes one synthetic run: a tuple like the daq writes, for steps of the working temperature
+// each step has a calibration with the heater off and two heater currents, the interface between the blocks has a known thermal resistance
+// ********************
+
+void generaterun(const std::string& name, int run, const std::vector<int>& order, double resistance)
+{
+
+	TFile* afile = new TFile(name.c_str(), "RECREATE");
+	TTree* atuple = new TTree("thermoDAQ", "thermoDAQ");
+	unsigned int uTime = 0;
+	float temperature[sensors];
+	float current1 = 0.0;
+	float workingTemperature = 0.0;
+	atuple->Branch("uTime", &uTime, "uTime/i");
+	for (int j=0;j<sensors;j++)
+	{
+		temperature[j] = 0.0;
+		atuple->Branch(Form("temperature%d", j), &temperature[j], Form("temperature%d/F", j));
+	}
+	atuple->Branch("current1", &current1, "current1/F");
+	atuple->Branch("workingTemperature", &workingTemperature, "workingTemperature/F");
+
+	TRandom3 random(run + 1);
+
+	// the working temperatures, the heater currents, the length of each part of a step and the time constant of the blocks
+	const double workingsteps[6] = {15.0, 20.0, 25.0, 30.0, 25.0, 20.0};
+	const double currents[3] = {0.0, 0.4, 0.6};
+	const long int phase = 3000;
+	const double tau = 300.0;
+	const double relax = 1.0 - exp(-1.0/tau);
+
+	// the thermal conductivity of the aluminium blocks in W/(mK)
+	const double lambda_al = 200.0;
+
+	// the positions of the sorted sensors: the heater on top, the blocks, the bath at the bottom
+	double position[sensors];
+	position[0] = 80.0;
+	for (int k=1;k<=8;k++)
+	{
+		position[k] = sensorposition[k-1];
+	}
+	position[9] = 0.0;
+
+	// each sensor reads off by a little, this is what the calibration removes
+	double offset[sensors];
+	for (int j=0;j<sensors;j++)
+	{
+		offset[j] = random.Uniform(-0.3, 0.3);
+	}
+
+	// the blocks start in equilibrium at the first working temperature
+	double truetemp[sensors];
+	for (int k=0;k<sensors;k++)
+	{
+		truetemp[k] = workingsteps[0];
+	}
+
+	unsigned int starttime = 1400000000 + 100000*run;
+	for (long int i=0;i<generateentries;i++)
+	{
+		double work = workingsteps[(i/(3*phase)) % 6];
+		double current = currents[(i/phase) % 3];
+
+		// the heat flows down through both blocks and the interface
+		double power = resistor*current*current;
+		double gradient = power/(lambda_al*area)/1000.0;
+		double drop = power*resistance;
+		for (int k=0;k<sensors;k++)
+		{
+			double target = work + gradient*position[k] + (position[k] > 40.0 ? drop : 0.0);
+			truetemp[k] += (target - truetemp[k])*relax;
+			temperature[order.at(k)] = truetemp[k] + offset[order.at(k)] + random.Gaus(0.0, generatenoise);
+		}
+		uTime = starttime + i;
+		current1 = current;
+		workingTemperature = work;
+		atuple->Fill();
+	}
+
+	afile->Write();
+	afile->Close();
+	delete afile;
+
+}
+
+
+// ********************
+// this function writes a synthetic campaign: the tuples and a runlist for them
+// ********************
+
+void generatecampaign()
+{
+
+	gSystem->mkdir(generatedir.c_str(), kTRUE);
+	std::string runlistname = generatedir + "/runlist.txt";
+	std::ofstream runlist(runlistname.c_str());
+	if (!runlist.is_open())
+	{
+		cout << "Error writing runlist file " << runlistname << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	runlist << "# Synthetic runlist, the comment is the thermal resistance of the interface" << endl;
+	runlist << "#" << endl;
+
+	// the line of the generated runlist each run is written into, for error messages
+	int linenumber = 2;
+
+	// two sensor sortings, so the sorting is exercised as well
+	const char* sortings[2] = {"0432156789", "8765401239"};
+	for (int run=0;run<generateruns;run++)
+	{
+		char tempchar[100];
+		sprintf(tempchar, "/run%i.root", run);
+		std::string name = generatedir + tempchar;
+		double resistance = 0.1 + 0.05*(run % 5);
+		linenumber++;
+		std::vector<int> order = compilesorting(sortings[run % 2], linenumber);
+		generaterun(name, run, order, resistance);
+		runlist << name << "," << sortings[run % 2] << ",,50,synthetic " << (char)('A' + run % 2) << ",interface " << resistance << " K/W" << endl;
+		if (debug<5)
+		{
+			cout << "Wrote " << generateentries << " entries into " << name << " !" << endl;
+		}
+	}
+
+	if (debug<5)
+	{
+		cout << "Wrote the runlist " << runlistname << " !" << endl;
+	}
+
+}
+
+
+// ********************
+// a function to quote a string for json
+// ********************
+
+std::string jsonstring(const std::string& astring)
+{
+	std::string quoted = "\"";
+	for (size_t i=0;i<astring.size();i++)
+	{
+		if (astring.at(i) == '"' || astring.at(i) == '\\')
+		{
+			quoted += '\\';
+		}
+		quoted += astring.at(i);
+	}
+	return quoted + "\"";
+}
+
+
+// ********************
+// a function to write the time of each stage of a profile as a json object
+// ********************
+
+void writestages(std::ostream& out, const double* stagetime)
+{
+	out << "{";
+	for (int k=0;k<nstages;k++)
+	{
+		out << (k > 0 ? ", " : "") << "\"" << stagename[k] << "\": " << stagetime[k];
+	}
+	out << "}";
+}
+
+
+// ********************
+// a function to sum the profiles of all runs and of the campaign
+// ********************
+
+runprofile sumprofiles()
+{
+	runprofile total = campaignprofile;
+	for (size_t ii=0;ii<profiles.size();ii++)
+	{
+		const runprofile& profile = profiles.at(ii);
+		total.entries += profile.entries;
+		total.usedentries += profile.usedentries;
+		total.bytesread += profile.bytesread;
+		total.bytesunzipped += profile.bytesunzipped;
+		total.stablepoints += profile.stablepoints;
+		total.fits += profile.fits;
+		total.gaps += profile.gaps;
+		total.duplicates += profile.duplicates;
+		total.objects += profile.objects;
+		total.outputbytes += profile.outputbytes;
+		for (int k=0;k<nstages;k++)
+		{
+			total.stagetime[k] += profile.stagetime[k];
+		}
+	}
+	return total;
+}
+
+
+// ********************
+// this function appends the time of each stage of this analysis to the benchmark file, as one line of json
+// ********************
+
+void writebenchmark(const std::string& runlist, double total)
+{
+
+	std::ofstream out(benchmarkfile.c_str(), std::ios::app);
+	if (!out.is_open())
+	{
+		cout << "Error writing benchmark file " << benchmarkfile << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	runprofile sum = sumprofiles();
+	out << "{\"runlist\": " << jsonstring(runlist) << ", \"runs\": " << filelist.size() << ", \"entries\": " << sum.entries;
+	out << ", \"precision\": " << precision << ", \"threads\": " << threads << ", \"backend\": " << backend;
+	out << ", \"total\": " << total << ", \"stages\": ";
+	writestages(out, sum.stagetime);
+	out << "}" << endl;
+
+	if (debug<5)
+	{
+		cout << "Timing of " << sum.entries << " entries in " << total << " s:";
+		for (int k=0;k<nstages;k++)
+		{
+			cout << " " << stagename[k] << " " << sum.stagetime[k] << " s";
+		}
+		cout << endl;
+	}
+
+}
+
+
+// ********************
+// this function writes the counters and stage times of each run into the summary file
+// ********************
+
+void writesummary(const std::string& runlist, double total)
+{
+
+	std::ofstream out(summaryfile.c_str());
+	if (!out.is_open())
+	{
+		cout << "Error writing summary file " << summaryfile << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+
+	runprofile sum = sumprofiles();
+	out << "{" << endl;
+	out << "\t\"runlist\": " << jsonstring(runlist) << "," << endl;
+	out << "\t\"precision\": " << precision << ", \"threads\": " << threads << ", \"backend\": " << backend << "," << endl;
+	out << "\t\"total\": " << total << ", \"entries\": " << sum.entries << ", \"usedentries\": " << sum.usedentries;
+	out << ", \"bytesread\": " << sum.bytesread << ", \"bytesunzipped\": " << sum.bytesunzipped;
+	out << ", \"gaps\": " << sum.gaps << ", \"duplicates\": " << sum.duplicates;
+	out << ", \"stablepoints\": " << sum.stablepoints << ", \"fits\": " << sum.fits << ", \"objects\": " << bookedobjects << ", \"outputbytes\": " << sum.outputbytes << "," << endl;
+	out << "\t\"stages\": ";
+	writestages(out, sum.stagetime);
+	out << "," << endl;
+
+	// only the runs analysed by this process
+	out << "\t\"runs\": [";
+	bool first = true;
+	for (size_t ii=0;ii<profiles.size();ii++)
+	{
+		if (!runselected(ii))
+		{
+			continue;
+		}
+		const runprofile& profile = profiles.at(ii);
+		out << (first ? "" : ",") << endl;
+		first = false;
+		out << "\t\t{\"run\": " << ii << ", \"file\": " << jsonstring(filelist.at(ii)) << ", \"stored\": " << (profile.stored ? "true" : "false");
+		out << ", \"aborted\": " << (results.size() > ii && results[ii].aborted ? "true" : "false") << ", \"thread\": " << profile.worker;
+		out << ", \"entries\": " << profile.entries << ", \"usedentries\": " << profile.usedentries;
+		out << ", \"bytesread\": " << profile.bytesread << ", \"bytesunzipped\": " << profile.bytesunzipped;
+		out << ", \"gaps\": " << profile.gaps << ", \"duplicates\": " << profile.duplicates;
+		out << ", \"stablepoints\": " << profile.stablepoints << ", \"fits\": " << profile.fits << ", \"objects\": " << profile.objects << ", \"outputbytes\": " << profile.outputbytes;
+		out << ", \"stages\": ";
+		writestages(out, profile.stagetime);
+		out << "}";
+	}
+	out << endl << "\t]" << endl;
+	out << "}" << endl;
+
+	if (debug<5)
+	{
+		cout << "Wrote the summary of " << profiles.size() << " runs into " << summaryfile << " !" << endl;
+	}
+
+}
+
+
+// ********************
+// this function writes the stages of all runs as a timeline in the chrome trace format, to be opened in chrome://tracing or perfetto
+// ********************
+
+void writetrace()
+{
+
+	std::ofstream out(tracefile.c_str());
+	if (!out.is_open())
+	{
+		cout << "Error writing trace file " << tracefile << " !" << endl;
+		exit ( EXIT_FAILURE );
+	}
+
+	// the threads are named once, the times are in microseconds
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+	int nthreads = 0;
+	for (size_t ii=0;ii<profiles.size();ii++)
+	{
+		nthreads = std::max(nthreads, profiles.at(ii).worker);
+	}
+	for (int t=0;t<=nthreads;t++)
+	{
+		out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << t << ", \"args\": {\"name\": \"" << (t == 0 ? "main" : Form("worker %i", t)) << "\"}}," << endl;
+	}
+
+	// the stages of all runs, then the stages that work on all runs
+	for (size_t ii=0;ii<=profiles.size();ii++)
+	{
+		const runprofile& profile = (ii < profiles.size()) ? profiles.at(ii) : campaignprofile;
+		for (size_t k=0;k<profile.spans.size();k++)
+		{
+			const tracespan& span = profile.spans.at(k);
+			out << "{\"name\": \"" << stagename[span.stage] << "\", \"cat\": \"" << (ii < profiles.size() ? "run" : "campaign") << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << span.thread;
+			out << ", \"ts\": " << (long long)(span.start*1e6) << ", \"dur\": " << (long long)((span.end - span.start)*1e6);
+			if (ii < profiles.size())
+			{
+				out << ", \"args\": {\"run\": " << ii << ", \"file\": " << jsonstring(filelist.at(ii)) << "}";
+			}
+			out << "}," << endl;
+		}
+	}
+
+	// json does not allow a comma after the last event
+	out << "{\"name\": \"end\", \"ph\": \"i\", \"s\": \"g\", \"pid\": 0, \"tid\": 0, \"ts\": " << (long long)(walltime()*1e6) << "}" << endl;
+	out << "]}" << endl;
+
+	if (debug<5)
+	{
+		cout << "Wrote the timeline into " << tracefile << " !" << endl;
+	}
+
+}
+
+
+// ********************
+// a function to turn a compression given as algorithm or algorithm:level into the settings root writes with
+// zstd needs root 6.20 and lz4 root 6.08, older roots only have zlib and lzma
+// ********************
+
+int compressionsettings(const std::string& setting)
+{
+	size_t pos = setting.find(':');
+	std::string algorithm = setting.substr(0, pos);
+	std::transform(algorithm.begin(), algorithm.end(), algorithm.begin(), ::tolower);
+
+	// the algorithm number of root and its recommended level
+	int code = -1;
+	int level = 1;
+	if (algorithm == "none")
+	{
+		return 0;
+	} else if (algorithm == "zlib") {
+		code = 1;
+		level = 1;
+	} else if (algorithm == "lzma") {
+		code = 2;
+		level = 7;
+	} else if (algorithm == "lz4") {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+		code = 4;
+		level = 4;
+#else
+		cout << "LZ4 compression needs ROOT 6.08 or newer!" << endl;
+		exit ( EXIT_FAILURE );
+#endif
+	} else if (algorithm == "zstd") {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,20,0)
+		code = 5;
+		level = 5;
+#else
+		cout << "ZSTD compression needs ROOT 6.20 or newer!" << endl;
+		exit ( EXIT_FAILURE );
+#endif
+	}
+	if (pos != std::string::npos)
+	{
+		level = atoi(setting.substr(pos + 1).c_str());
+	}
+	if (code < 0 || level < 1 || level > 9)
+	{
+		cout << "The compression has to be zstd, lz4, zlib, lzma or none, with a level from 1 to 9, e.g. zstd:5!" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	return 100*code + level;
+}
+
+
+// ********************
+// read the command line: the runlist and any options
+// ********************
+
+void readoptions(int argc, char** argv, std::string& astring)
+{
+	for (int i=1;i<argc;i++)
+	{
+		std::string option = argv[i];
+		if ((option == "--threads" || option == "-j") && i+1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		} else if (option == "--fused" && i+1 < argc) {
+			fused = atoi(argv[++i]);
+		} else if (option == "--iomode" && i+1 < argc) {
+			iomode = atoi(argv[++i]);
+		} else if (option == "--backend" && i+1 < argc) {
+			backend = atoi(argv[++i]);
+		} else if (option == "--kernel" && i+1 < argc) {
+			kernel = atoi(argv[++i]);
+		} else if (option == "--window" && i+1 < argc) {
+			stablewindow = atof(argv[++i]);
+		} else if (option == "--precision" && i+1 < argc) {
+			precision = atoi(argv[++i]);
+		} else if (option == "--plotpoints" && i+1 < argc) {
+			plotpoints = atoi(argv[++i]);
+		} else if (option == "--cache" && i+1 < argc) {
+			cachedir = argv[++i];
+		} else if (option == "--store" && i+1 < argc) {
+			storedir = argv[++i];
+		} else if (option == "--output" && i+1 < argc) {
+			outputname = argv[++i];
+		} else if (option == "--shard" && i+1 < argc) {
+			if (sscanf(argv[++i], "%i/%i", &shard, &shards) != 2 || shards < 1 || shard < 0 || shard >= shards)
+			{
+				cout << "The shard has to be given as I/N with 0 <= I < N!" << endl;
+				exit ( EXIT_FAILURE );
+			}
+		} else if (option == "--merge" && i+1 < argc) {
+			mergelist.push_back(argv[++i]);
+		} else if (option == "--follow") {
+			follow = 1;
+		} else if (option == "--discover" && i+1 < argc) {
+			discoverlist.push_back(argv[++i]);
+		} else if (option == "--exclude" && i+1 < argc) {
+			excludelist.push_back(argv[++i]);
+		} else if (option == "--sorting" && i+1 < argc) {
+			discoversorting = argv[++i];
+		} else if (option == "--broken" && i+1 < argc) {
+			discoverbroken = argv[++i];
+		} else if (option == "--thickness" && i+1 < argc) {
+			discoverthickness = argv[++i];
+		} else if (option == "--generate" && i+1 < argc) {
+			generatedir = argv[++i];
+		} else if (option == "--runs" && i+1 < argc) {
+			generateruns = atoi(argv[++i]);
+		} else if (option == "--entries" && i+1 < argc) {
+			generateentries = atol(argv[++i]);
+		} else if (option == "--noise" && i+1 < argc) {
+			generatenoise = atof(argv[++i]);
+		} else if (option == "--benchmark" && i+1 < argc) {
+			benchmarkfile = argv[++i];
+		} else if (option == "--summary" && i+1 < argc) {
+			summaryfile = argv[++i];
+		} else if (option == "--trace" && i+1 < argc) {
+			tracefile = argv[++i];
+		} else if (option == "--render" && i+1 < argc) {
+			renderprocesses = atoi(argv[++i]);
+		} else if (option == "--export" && i+1 < argc) {
+			exportformats = argv[++i];
+		} else if (option == "--compression" && i+1 < argc) {
+			compression = compressionsettings(argv[++i]);
+		} else if (option == "--series") {
+			seriesmode = 1;
+		} else if (option == "--headless") {
+			headless = 1;
+		} else if (option == "--fitcheck") {
+			fitcheck = 1;
+		} else if (option == "--table" && i+1 < argc) {
+			tablename = argv[++i];
+		} else if (option == "--replay" && i+1 < argc) {
+			replayspeed = atof(argv[++i]);
+			follow = 1;
+		} else if (option.substr(0,1) == "-") {
+			cout << "Unknown option " << option << " !" << endl;
+			cout << "Usage: " << argv[0] << " /path/to/runlist [--threads N] [--fused 0|1] [--iomode 0|1] [--backend 0|1] [--kernel 0|1] [--window S] [--precision N] [--plotpoints N] [--cache DIR] [--store DIR] [--output FILE] [--shard I/N] [--merge FILE] [--follow] [--replay SPEED] [--generate DIR [--runs N] [--entries N] [--noise K]] [--benchmark FILE] [--summary FILE] [--trace FILE] [--compression ALGORITHM[:LEVEL]] [--series] [--headless] [--fitcheck] [--table FILE] [--render N] [--export png,pdf] [--discover DIR [--exclude NAME] [--sorting S] [--broken B] [--thickness T]]" << endl;
+			exit ( EXIT_FAILURE );
+		} else {
+			astring = option;
+		}
+	}
+	if (precision < 1)
+	{
+		cout << "The precision has to be at least 1!" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	if (plotpoints < 0 || plotpoints == 1 || plotpoints == 2)
+	{
+		cout << "The points of a time graph have to be 0 (all) or at least 3, to keep the first and the last one!" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	if (shards > 1 && !mergelist.empty())
+	{
+		cout << "A shard can not merge results!" << endl;
+		exit ( EXIT_FAILURE );
+	}
+	if (follow == 1 && (shards > 1 || !mergelist.empty() || cachedir != "" || backend == 1 || mode != 3))
+	{
+		cout << "Following a tuple needs mode 3 and works without --shard, --merge, --cache and --backend 1!" << endl;
+		exit ( EXIT_FAILURE );
+	}
+
+	// each shard writes its own output
+	if (shards > 1 && outputname == "output.root")
+	{
+		char tempchar[100];
+		sprintf(tempchar, "output_shard%i.root", shard);
+		outputname = tempchar;
+	}
+
+	if (headless == 1 && exportformats != "")
+	{
+		cout << "There are no canvases to export in headless mode!" << endl;
+		exit ( EXIT_FAILURE );
+	}
+
+	// the images go next to the output
+	exportdir = outputname;
+	if (exportdir.size() > 5 && exportdir.substr(exportdir.size()-5) == ".root")
+	{
+		exportdir = exportdir.substr(0, exportdir.size()-5);
+	}
+	seriesdir = exportdir + "_series";
+	exportdir += "_plots";
+
+	// the nightly analysis only needs the numbers
+	if (headless == 1 && tablename == "")
+	{
+		tablename = outputname;
+		if (tablename.size() > 5 && tablename.substr(tablename.size()-5) == ".root")
+		{
+			tablename = tablename.substr(0, tablename.size()-5);
+		}
+		tablename += "_results.csv";
+	}
+}
+
+
+// ********************
+// the main function
+// ********************
+
+int main(int argc, char** argv)
+{
+
+	// user inputs which runlist to read
+	std::string astring = "fail";
+	readoptions(argc, argv, astring);
+
+	// reading several files at once, or replaying one, needs a thread-safe root, before any root object is made
+	if (threads != 1 || replayspeed > 0.0)
+	{
+		ROOT::EnableThreadSafety();
+	}
+
+	// only write a synthetic campaign
+	if (generatedir != "")
+	{
+		generatecampaign();
+		return 0;
+	}
+
+	// only write a runlist of the runs found
+	if (!discoverlist.empty())
+	{
+		discoverruns(astring == "fail" ? "outputlist.txt" : astring);
+		return 0;
+	}
+
+	if (astring == "fail")
+	{
+		cout << "You did not specify a runlist! Please input a runlist now:" << endl;
+		getline (cin, astring);
+	}
+
+	// the output file we want to save into
+	outputFile = new TFile(outputname.c_str(), "RECREATE");
+	if (compression >= 0)
+	{
+		outputFile->SetCompressionSettings(compression);
+	}
+
+	// the rdataframe backend reads ranges of each tuple on the threads, one run after the other
+	if (backend == 1)
+	{
+#if ROOT_VERSION_CODE < ROOT_VERSION(6,16,0)
+		cout << "The RDataFrame backend needs ROOT 6.16 or newer!" << endl;
+		exit ( EXIT_FAILURE );
+#endif
+		if (stablewindow > 0.0)
+		{
+			cout << "The stability detector window needs --backend 0!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		if (cachedir != "")
+		{
+			cout << "The column cache needs --backend 0!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+		if (mode < 1 || mode > 3)
+		{
+			cout << "The RDataFrame backend needs mode 1, 2 or 3!" << endl;
+			exit ( EXIT_FAILURE );
+		}
+	}
+
+	// how long does it take until we start reading?
+	TStopwatch startup;
+	startup.Start();
+	double starttime = walltime();
+
+	// read the runlist into the vectors
+	readrunlist(astring);
+
+	// then prepare the roots
+	prepareroot();
+
+	startup.Stop();
+	stagedone(campaignprofile, stagebooking, starttime);
+	if (debug<5)
+	{
+		ProcInfo_t procinfo;
+		gSystem->GetProcInfo(&procinfo);
+		cout << "Booked " << bookedobjects << " ROOT objects for " << filelist.size() << " runs in " << startup.RealTime() << " s, resident memory " << procinfo.fMemResident/1024.0 << " MB." << endl;
+		cout << " " << endl;
+	}
+
+	// loop over each measurement in the runlist, follow the last one, or take the results of all shards
+	if (!mergelist.empty())
+	{
+		mergeshards();
+	} else if (follow == 1) {
+		followrun(filelist.size()-1);
+	} else {
+		runscheduler();
+	}
+
+	// the plots only need the results
+	renderplots();
+
+	// the numbers of all stable points
+	if (tablename != "")
+	{
+		writetable();
+	}
+
+	// now time to do some comparisons between measurement runs, a shard leaves them to the merge
+	if (shards > 1)
+	{
+		std::string resultsname = outputname;
+		if (resultsname.size() > 5 && resultsname.substr(resultsname.size()-5) == ".root")
+		{
+			resultsname = resultsname.substr(0, resultsname.size()-5);
+		}
+		saveshard(resultsname + ".results");
+	} else {
+		double comparisontime = walltime();
+		comparemeasurements();
+		stagedone(campaignprofile, stagecomparison, comparisontime);
+	}
+
+	// the output is complete
+	outputFile->Close();
+	if (debug<5)
+	{
+		struct stat info;
+		long long size = (stat(outputname.c_str(), &info) == 0) ? info.st_size : 0;
+		cout << "Wrote " << size << " bytes into " << outputname << " with compression settings " << (compression >= 0 ? compression : -1) << " !" << endl;
+	}
+
+	// how long did all of this take?
+	double total = walltime() - starttime;
+	if (benchmarkfile != "")
+	{
+		writebenchmark(astring, total);
+	}
+	if (summaryfile != "")
+	{
+		writesummary(astring, total);
+	}
+	if (tracefile != "")
+	{
+		writetrace();
 	}
-	outputFile->cd();
 
 	// not sure if needed...
 	return 0;